@@ -1,920 +1,5558 @@
-
-// Huffman.h : 头文件
-//
-
-
-#pragma once
-
-#include <deque>
-#include <algorithm>
-#include <cmath>
-#include <map>
-#include <vector>
-using namespace std;
-
-
-/*哈夫曼编码*/
-class CHuffmanCode
-{
-public:
-	CHuffmanCode()
-		:m_CodeLen(0), m_pCode(nullptr)
-	{
-	}
-	CHuffmanCode(int codeLen)
-		:m_CodeLen(codeLen) 
-	{
-		m_pCode = new char[m_CodeLen];
-		for(int i=0; i<m_CodeLen; i++) 
-			m_pCode[i] = 0;
-	}
-	CHuffmanCode(int codeLen, CHuffmanCode& initVal)
-		:m_CodeLen(codeLen) 
-	{
-		m_pCode = new char[m_CodeLen];
-		for(int i=0; i<m_CodeLen; i++) 
-			m_pCode[i] = 0;
-
-		int start;
-		char * ptr = m_pCode + m_CodeLen - 1;
-
-		if(m_CodeLen >= initVal.m_CodeLen)
-		{
-			start = 0;
-		}
-		else
-		{
-			start = initVal.m_CodeLen - m_CodeLen;
-		}
-
-		for(int i=initVal.m_CodeLen-1; i>=start; i--)
-		{
-			*ptr = initVal.m_pCode[i];
-			ptr--;
-		}
-	}
-
-	~CHuffmanCode() 
-	{
-		if(m_pCode != nullptr) 
-		{
-			delete[] m_pCode;
-			m_pCode = nullptr;
-		}
-		m_CodeLen = 0;
-	}
-
-	CHuffmanCode& operator+=(char bit) 
-	{
-		for(int i=m_CodeLen-1; i>=0; i--)
-		{
-			m_pCode[i] += bit;
-
-			if(m_pCode[i] < 2)
-			{
-				break;
-			}
-
-			m_pCode[i] = 0;
-		}
-
-        return *this;
-    }
-
-	CHuffmanCode& operator<<=(int k) 
-	{
-		if(k >= m_CodeLen)
-		{
-			for(int i=m_CodeLen-1; i>=0; i--)
-			{
-				m_pCode[i] = 0;
-			}
-
-		}
-		else
-		{
-			for(int i=0; i<m_CodeLen-k; i++)
-			{
-				m_pCode[i] = m_pCode[i+k];
-			}
-			for(int i=m_CodeLen-k; i<m_CodeLen; i++)
-			{
-				m_pCode[i] = 0;
-			}
-		}
-
-        return *this;
-    }
-
-	void GetCode(char ** ppCode, int * pCodeLen)
-	{
-		if(m_pCode != nullptr)
-		{
-			*ppCode = new char[m_CodeLen];
-			memcpy(*ppCode, m_pCode, m_CodeLen);
-			*pCodeLen = m_CodeLen;
-		}
-		else
-		{
-			*ppCode = nullptr;
-			*pCodeLen = 0;
-		}
-	}
-
-	void SimpReset()
-	{
-		m_pCode = nullptr;
-		m_CodeLen = 0;
-	}
-
-	char * GetCodePtr()
-	{
-		return m_pCode;
-	}
-	int GetCodeLen()
-	{
-		return m_CodeLen;
-	}
-
-	void PaintSkin(CHuffmanCode& hfmcode)
-	{
-		if(this != &hfmcode)
-		{
-			if(m_pCode != nullptr)
-			{
-				delete[] m_pCode;
-			}
-			m_pCode = hfmcode.GetCodePtr();
-			m_CodeLen = hfmcode.GetCodeLen();
-			hfmcode.SimpReset();
-		}
-	}
-
-
-private:
-	char * m_pCode;
-	int m_CodeLen;
-};
-
-/*哈夫曼树的节点定义*/
-template <typename T>
-struct HuffmanNode
-{
-    HuffmanNode(T k,HuffmanNode<T>*l=nullptr,HuffmanNode<T>* r=nullptr,HuffmanNode<T>* p=nullptr)
-        :key(k), lchild(l), rchild(r), parent(p), code(-1), idx(-1){}
-    ~HuffmanNode(){};
-	int idx;					// 创建时节点索引, nodes和create()参数a[]中的索引, 解码时输出这个索引
-	char code;					// 节点哈夫曼编码
-    T key;                      //节点的权值
-    HuffmanNode<T>* parent;        //父节点
-    HuffmanNode<T>* lchild;        //节点左孩
-    HuffmanNode<T>* rchild;        //节点右孩
-};
-
-typedef char*	_CodePtr;
-
-template <typename T>
-class CHuffman
-{
-public:
-    void preOrder();              //前序遍历哈夫曼树
-    void inOrder();                  //中序遍历哈夫曼树
-    void postOrder();              //后序遍历哈夫曼树
- 
-	void CanonicCreat(T w[],int size);
-    void creat(T a[], int size);		//创建哈夫曼树
-    void recreat();						//根据范式编码重建哈夫曼树
-    void destroy();						//销毁哈夫曼树
-    void print();						//打印哈夫曼树
-    void printCode();						//打印哈夫曼树
-	bool getCode(int iIndex, char ** ppCode, int * plen);	// 指定索引的哈夫编码, 返回编码长度
-	bool getCode(int * plen);	// 返回编码长度
-	void Reset(){ destroy(); }
-	HuffmanNode<T>* GetRoot(){return root;}
-	void ClearCodePtr();
-
-    CHuffman();
-    virtual ~CHuffman(){ destroy(); ClearCodePtr(); TRACE("called destructor of class CHuffman!\r\n"); };
- 
-private:
-    void preOrder(HuffmanNode<T>* pnode);
-    void inOrder(HuffmanNode<T>* pnode);
-    void postOrder(HuffmanNode<T>*pnode);
-    void print(HuffmanNode<T>*pnode);
-	// 返回编码长度
-	bool getCodeLen();
-	void CanonicCodeByLens(T w[],int sz);
-
-protected:
-	vector<int>	m_vecCodeLens;		// 编码长度
-	_CodePtr * m_pCodePtr;
- 
-private:
-    HuffmanNode<T>* root;			//哈夫曼树根节点
-    deque<HuffmanNode<T>*> nodes;	//叶子节点
-    deque<HuffmanNode<T>*> forest;	//森林
-};
-
-template<typename T>
-void CHuffman<T>::ClearCodePtr()
-{
-	if(m_pCodePtr != nullptr)
-	{
-		int size = m_vecCodeLens.size();
-		for(int i=0; i<size; i++)
-		{
-			if(m_pCodePtr[i] != nullptr)
-			{
-				delete[] m_pCodePtr[i];
-				m_pCodePtr[i] = nullptr;
-			}
-		}
-
-		delete[] m_pCodePtr;
-		m_pCodePtr = nullptr;
-	}
-	m_vecCodeLens.clear();
-}
-
-template<typename T>
-void CHuffman<T>::printCode()						//打印哈夫曼树
-{
-	int size = m_vecCodeLens.size();
-
-	for(int i=0; i<size; i++)
-	{
-		int len = m_vecCodeLens[i];
-		_CodePtr codePtr = m_pCodePtr[i];
-
-		for(int j=0; j<len; j++)
-		{
-			TRACE("%d", codePtr[j]);
-		}
-		TRACE(" -- %d\r\n", i);
-	}
-}
-
-/*创建哈夫曼树*/
-template<typename T>
-CHuffman<T>::CHuffman()
-{
-	root = nullptr;
-	m_pCodePtr = nullptr;
-}
-
-// 返回编码长度
-template<typename T>
-bool CHuffman<T>::getCodeLen()
-{
-	int size = nodes.size();
-
-	if(size == 1)
-	{
-		m_vecCodeLens.push_back(1);
-	}
-	else
-	{
-		for(int j=0; j<size; j++)
-		{
-			int codeLen = 0;
-			HuffmanNode<T>* node = nodes[j];
-			while(node->parent != nullptr)
-			{
-				codeLen += 1;
-				node = node->parent;
-			}
-
-			m_vecCodeLens.push_back(codeLen);
-		}
-	}
-
-	return true;
-}
-
-template<typename T>
-void CHuffman<T>::CanonicCodeByLens(T w[],int sz)
-{
-	// 编码长度与索引对应列表, 并按编码长度排序
-	deque<pair<int, int>>	deqCodeLen;
-
-	int size = m_vecCodeLens.size();
-
-	for(int i=0; i<size; i++)
-	{
-		deqCodeLen.push_back(pair<int,int>(m_vecCodeLens[i], i));
-	}
-	// 排序
-	sort(deqCodeLen.begin(), deqCodeLen.end(), [](pair<int,int> & it1, pair<int,int> & it2){return it1.first < it2.first;});
-
-	m_pCodePtr = new _CodePtr[size];
-
-	int codeLen = deqCodeLen[0].first;
-	int idx = deqCodeLen[0].second;
-
-	CHuffmanCode hfmCode(codeLen);
-	int icodelen = 0;
-	hfmCode.GetCode(m_pCodePtr + idx, &icodelen);
-
-	for(int ii=0; ii<icodelen; ii++)
-	{
-		TRACE("%d",m_pCodePtr[idx][ii]);
-	}
-	TRACE(" -- idx:%d, cnt:%d, code len:%d, id:%d - huffman code\r\n", idx, w[idx], codeLen, 0);
-
-	for(int i=1; i<size; i++)
-	{
-		int curcodeLen = deqCodeLen[i].first;
-		int curidx = deqCodeLen[i].second;
-
-		CHuffmanCode curhfmCode(curcodeLen, hfmCode);
-		curhfmCode += 1;
-
-		if(curcodeLen > codeLen)
-		{
-			curhfmCode <<= (curcodeLen - codeLen);
-		}
-
-		int icodelen = 0;
-		curhfmCode.GetCode(m_pCodePtr + curidx, &icodelen);
-		codeLen = curcodeLen;
-		hfmCode.PaintSkin(curhfmCode);
-
-		for(int ii=0; ii<icodelen; ii++)
-		{
-			TRACE("%d",m_pCodePtr[curidx][ii]);
-		}
-		TRACE(" -- idx:%d, cnt:%d, code len:%d, id:%d - huffman code\r\n", curidx, w[curidx], curcodeLen, i);
-	}
-}
-
-
-template<typename T>
-void CHuffman<T>::CanonicCreat(T w[],int size)
-{
-	creat(w,size);
-
-	// 返回编码长度
-	getCodeLen();
-	//范式编码
-	CanonicCodeByLens(w,size);
-	// 范式编码重建哈夫曼树
-	destroy();
-	recreat();
-}
-
-//根据编码重建哈夫曼树
-template<typename T>
-void CHuffman<T>::recreat()
-{
-	int size = m_vecCodeLens.size();
-
-	if(size == 1)
-	{
-		root = new HuffmanNode<T>(0,nullptr,nullptr,nullptr); 
-		root->idx = 0;
-		root->code = 0;
-	}
-	else
-	{
-		root = new HuffmanNode<T>(0,nullptr,nullptr,nullptr); 
-
-		for(int i=0; i<size; i++)
-		{
-			_CodePtr codePtr = m_pCodePtr[i];
-			int codeLen = m_vecCodeLens[i];
-
-			HuffmanNode<T>* node = root;
-
-			for(int j=0; j<codeLen; j++)
-			{
-				if(codePtr[j] == 0)
-				{
-					if(node->lchild == nullptr)
-					{
-						HuffmanNode<T> * newnode = new HuffmanNode<T>(0,nullptr,nullptr,node); 
-						newnode->code = 0;
-						node->lchild = newnode;
-						if(j == (codeLen - 1))
-						{
-							newnode->idx = i;
-							nodes.push_back(newnode);
-						}
-					}
-
-					node = node->lchild;
-				}
-
-				if(codePtr[j] == 1)
-				{
-					if(node->rchild == nullptr)
-					{
-						HuffmanNode<T> * newnode = new HuffmanNode<T>(0,nullptr,nullptr,node); 
-
-						newnode->code = 1;
-						node->rchild = newnode;
-
-						if(j == (codeLen - 1))
-						{
-							newnode->idx = i;
-							nodes.push_back(newnode);
-						}
-					}
-
-					node = node->rchild;
-				}
-			}
-
-		}
-	}
-}
-
-/*创建哈夫曼树*/
-template<typename T>
-void CHuffman<T>::creat(T a[],int size)
-{
-    for (int i = 0; i < size; i++) //每个节点都作为一个森林
-    {
-        //为初始序列的元素构建节点。每个节点作为一棵树加入森林中。
-        HuffmanNode<T>* ptr = new HuffmanNode<T>(a[i],nullptr,nullptr,nullptr);  
-		ptr->idx = i;
-        nodes.push_back(ptr);
-        forest.push_back(ptr);
-		
-    }
-
-	if(size == 1)
-	{
-		forest[0]->code = 0;
-	}
-
-    for (int i = 0; i < size - 1; i++)
-    {
-        //排序，以选出根节点权值最小两棵树
-		//for(int i=0; i<forest.size(); i++)
-		//	TRACE("%.1f(l%d, r%d), ", (float)forest[i]->key, (short)forest[i]->lchild, (short)forest[i]->rchild);
-		//TRACE("org\r\n");
-        sort(forest.begin(), forest.end(), [](HuffmanNode<T>* a, HuffmanNode<T>*b){return a->key < b->key; });    
-		//for(int i=0; i<forest.size(); i++)
-		//	TRACE("%.1f(l%d, r%d), ", (float)forest[i]->key, (short)forest[i]->lchild, (short)forest[i]->rchild);
-		//TRACE("sort\r\n");
-        HuffmanNode<T>*node = new HuffmanNode<T>(forest[0]->key + forest[1]->key, forest[0], forest[1]); //构建新节点
-        forest[0]->parent = node;
-        forest[1]->parent = node;
-		forest[0]->code = 0;
-		forest[1]->code = 1;
-		forest.push_back(node);  //新节点加入森林中
-        forest.pop_front(); //删除两棵权值最小的树
-        forest.pop_front();
-    }
-    root = forest.front();
-    forest.clear();
-}
-
-/*打印哈夫曼树*/
-template<typename T>
-void CHuffman<T>::print()
-{
-	print(root);
-}
-
-/*打印哈夫曼树*/
-template<typename T>
-void CHuffman<T>::print(HuffmanNode<T>* pnode)
-{
-    if (pnode != nullptr)
-    {
-		TRACE("当前结点: %.2f. ", (float)pnode->key);
-        if (pnode->lchild != nullptr)
-            TRACE("它的左孩子节点为： %.2f.", (float)pnode->lchild->key);
-        else 
-			TRACE("它没有左孩子.");
-        if (pnode->rchild != nullptr)
-            TRACE("它的右孩子节点为： %.2f.", (float)pnode->rchild->key);
-        else 
-			TRACE("它没有右孩子.");
-		TRACE("\r\n");
-
-        print(pnode->lchild);
-        print(pnode->rchild);
-    }
-}
-
-//销毁哈夫曼树
-template<typename T>
-void CHuffman<T>::destroy()
-{
-	//结点集
-    deque<HuffmanNode<T>*> nodes; 
-	HuffmanNode<T>*pnode = root;
-
-    while(pnode != nullptr)
-    {
-		if(pnode->lchild != nullptr)
-		{
-			nodes.push_back(pnode->lchild);
-		}
-		if(pnode->rchild != nullptr)
-		{
-			nodes.push_back(pnode->rchild);
-		}
-
-		delete pnode;
-		pnode = nullptr;
-
-		if(nodes.empty())
-		{
-			break;
-		}
-
-		pnode = nodes[0];
-		nodes.pop_front();
-	}
-
-	this->nodes.clear();
-	root = nullptr;
-}
-
-// ppCode - 指定索引的哈夫编码, len - 返回编码长度
-template<typename T>
-bool CHuffman<T>::getCode(int iIndex, char ** ppCode, int * plen)
-{
-	if(root == nullptr)
-	{	
-		return false;
-	}
-
-	int size = nodes.size();
-	if(iIndex >= size)
-	{
-		return false;
-	}
-
-	if(size == 1)
-	{
-		*ppCode = new char[1];
-		(*ppCode)[0] = nodes[0]->code;
-		*plen = 1;
-	}
-	else
-	{
-		int codeLen = 0;
-		HuffmanNode<T>* node = nodes[iIndex];
-		while(node->parent != nullptr)
-		{
-			codeLen += 1;
-			node = node->parent;
-		}
-
-		char * pcode = new char[codeLen];
-		node = nodes[iIndex];
-		for(int i=codeLen-1; i>=0; i--)
-		{
-			pcode[i] = node->code;
-			node = node->parent;
-		}
-
-		*ppCode = pcode;
-		*plen = codeLen;
-	}
-
-	return true;
-}
-
-
-template<typename T>
-class CElemStat
-{
-public:
-	typedef pair <T, int> Elem_Pair;
-
-	int Stat(T * pText, int size);
-	int GetElemNum();
-	int GetStat(T * pElems, int * pCnts, int size);
-	void Clear();
-
-	CElemStat(){}
-    virtual ~CElemStat(){TRACE("called destructor of class CElemStat!\r\n");}
- 
-private:
-	map<T, int>		m_mapStat;
-};
-
-template<typename T>
-void CElemStat<T>::Clear()
-{
-	if(!m_mapStat.empty())
-		m_mapStat.clear();
-}
-
-template<typename T>
-int CElemStat<T>::Stat(T * pText, int size)
-{
-	Clear();
-
-	for(int i=0; i<size; i++)
-	{
-		map<T, int>::iterator iter = m_mapStat.find(pText[i]);
-		if(iter == m_mapStat.end())
-		{
-			m_mapStat.insert(Elem_Pair(pText[i], 1));
-		}
-		else
-		{
-			iter->second++;
-		}
-	}
-
-	return m_mapStat.size();
-}
-
-template<typename T>
-int CElemStat<T>::GetStat(T * pElems, int * pCnts, int size)
-{
-	int rsize = m_mapStat.size();
-	if(rsize <= size)
-	{
-		T * ptrElem = pElems;
-		int * ptrCnt = pCnts;
-
-		map<T, int>::iterator iter = m_mapStat.begin();
-		while(iter != m_mapStat.end())
-		{
-			*ptrElem = iter->first;
-			*ptrCnt = iter->second;
-			ptrElem++;
-			ptrCnt++;
-			iter++;
-		}
-
-		return rsize;
-	}
-	else
-	{
-		return 0;
-	}
-}
-
-template<typename T>
-int CElemStat<T>::GetElemNum()
-{
-	int rsize = m_mapStat.size();
-	return rsize;
-}
-
-template<typename _EL, typename _WT>
-class CHuffmanCodec: 
-	public CElemStat<_EL>, public CHuffman<_WT>
-{
-public:
-	typedef CElemStat<_EL> _ElemStat;
-	typedef CHuffman<_WT> _Huffman;
-	typedef char*	_CodePtr;
-
-	CHuffmanCodec():_ElemStat(), _Huffman()
-	{
-		m_pElems = nullptr;
-		m_pWeights = nullptr;
-		m_pCodePtr = nullptr;
-		m_pCodeLen = nullptr;
-		m_iElemNum = 0;
-	}
-	virtual ~CHuffmanCodec(){Reset(); TRACE("called destructor of class CHuffmanCodec!\r\n");}
-
-	int Encode(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen);
-	int Decode(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen);
-
-public:
-	void Reset();
-
-private:
-	_EL * m_pElems;
-	_WT * m_pWeights;
-	_CodePtr *	m_pCodePtr;
-	int * m_pCodeLen;
-	map<_EL, int>	m_mapElemIdx;
-	int	  m_iElemNum;
-	vector<char>	m_vecEnText;
-	vector<char>	m_vecDeText;
-};
-
-
-template<typename _EL, typename _WT>
-void CHuffmanCodec<_EL, _WT>::Reset()
-{
-	if(m_pElems != nullptr)
-	{
-		delete[] m_pElems;
-		m_pElems = nullptr;
-	}
-	if(m_pWeights != nullptr)
-	{
-		delete[] m_pWeights;
-		m_pWeights = nullptr;
-	}
-	if(m_pCodePtr != nullptr)
-	{
-		for(int i=0; i<m_iElemNum; i++)
-		{
-			delete[] m_pCodePtr[i];
-			m_pCodePtr[i] = nullptr;
-		}
-
-		delete[] m_pCodePtr;
-		m_pCodePtr = nullptr;
-	}
-
-	if(m_pCodeLen != nullptr)
-	{
-		delete[] m_pCodeLen;
-		m_pCodeLen = nullptr;
-	}
-
-	m_mapElemIdx.clear();
-	m_vecEnText.clear();
-
-	_ElemStat::Clear();
-	_Huffman::Reset();
-}
-
-template<typename _EL, typename _WT>
-int CHuffmanCodec<_EL, _WT>::Encode(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen)
-{
-	Reset();
-
-	int elemnum = Stat(pText, iTextLen);
-
-	m_pElems = new _EL[elemnum];
-	m_pWeights = new _WT[elemnum];
-	m_iElemNum = GetStat(m_pElems, m_pWeights, elemnum);
-
-	TRACE("Elem: ");
-	for(int i=0; i<elemnum; i++)
-	{
-		TRACE("%c, ", m_pElems[i]);
-	}
-	TRACE("\r\n");
-
-	TRACE("Len: ");
-	for(int i=0; i<elemnum; i++)
-	{
-		TRACE("%d, ", m_pWeights[i]);
-	}
-	TRACE("\r\n");
-
-	TRACE("idx: ");
-	for(int i=0; i<elemnum; i++)
-	{
-		TRACE("%d, ", i);
-	}
-	TRACE("\r\n");
-
-	CanonicCreat(m_pWeights, m_iElemNum);
-
-	for(int i=0; i<elemnum; i++)
-	{
-		m_mapElemIdx[m_pElems[i]] = i;
-	}
-
-	m_pCodePtr = new _CodePtr[elemnum];
-	m_pCodeLen = new int[elemnum];
-
-	for(int i=0; i<elemnum; i++)
-	{
-		m_pCodeLen[i] = 0;
-		m_pCodePtr[i] = nullptr;
-		bool bret = getCode(i, m_pCodePtr + i, m_pCodeLen + i);
-		for(int j=0; j<m_pCodeLen[i]; j++)
-		{
-			//TRACE("%d", m_pCodePtr[i][j]);
-		}
-		//TRACE(" -- char: %c (%d) - cnt: %d 哈夫曼编码.\r\n", m_pElems[i], m_pElems[i], m_pWeights[i]);
-	}
-	
-	for(int i=0; i<iTextLen; i++)
-	{
-		int idx = m_mapElemIdx[pText[i]];
-		_CodePtr codeptr = CHuffman<_WT>::m_pCodePtr[idx];
-
-		for(int j=0; j<CHuffman<_WT>::m_vecCodeLens[idx]; j++)
-		{
-			m_vecEnText.push_back(codeptr[j]);
-		}
-	}
-
-	int iEnTextLen = m_vecEnText.size();
-	char * pEnText = new char[iEnTextLen];
-
-	for(int i=0; i<iEnTextLen; i++)
-	{
-		pEnText[i] = m_vecEnText[i];
-	}
-
-	*ppOutput = pEnText;
-	*pOutputLen = iEnTextLen;
-	
-	return iEnTextLen;
-}
-
-template<typename _EL, typename _WT>
-int CHuffmanCodec<_EL, _WT>::Decode(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen)
-{
-	HuffmanNode<_WT>*pnode = GetRoot();
-
-	if((pnode->lchild == nullptr) && (pnode->rchild == nullptr))
-	{
-		for(int i=0; i<iTextLen; i++)
-		{
-			m_vecDeText.push_back(m_pElems[0]);
-		}
-	}
-	else
-	{
-		for(int i=0; i<iTextLen; i++)
-		{
-			if(pText[i] == 0)
-			{
-				pnode = pnode->lchild;
-			}
-			else
-			{
-				pnode = pnode->rchild;
-			}
-
-			if((pnode->lchild == nullptr) && (pnode->rchild == nullptr))
-			{
-				m_vecDeText.push_back(m_pElems[pnode->idx]);
-				pnode = GetRoot();
-			}
-		}
-	}
-
-	int iDeTextLen = m_vecDeText.size();
-	char * pDeText = new char[iDeTextLen+1];
-
-	for(int i=0; i<iDeTextLen; i++)
-	{
-		pDeText[i] = m_vecDeText[i];
-	}
-
-	pDeText[iDeTextLen] = '\0';
-
-	*ppOutput = pDeText;
-	*pOutputLen = iDeTextLen;
-	
-	return iDeTextLen;
-}
-
-/** 
-// test code
-char g_text[] = "ADFHFAAAAHFGKKKKJJJJJJJJJJEEvkwwuuuuu";
-
-void CHuffmanDemoDlg::OnBnClickedButton1()
-{
-	// TODO: 在此添加控件通知处理程序代码
-	TRACE("text:%s\r\n", g_text); 
-	CHuffmanCodec<char, int> hfmCodec;
-	char * pOutput;
-	int iOutputLen;
-	int textlen = strlen(g_text);
-	int len = hfmCodec.Encode(g_text, textlen, &pOutput, &iOutputLen);
-	TRACE("encode:");
-	for(int i=0; i<iOutputLen; i++)
-	{
-		TRACE("%d", pOutput[i]);
-		if((1+i)%130==0)
-			TRACE("\r\n");
-	}
-
-	TRACE("\r\ntext bit count: %d, after encoding:%d \r\n", textlen * 8, iOutputLen);
-
-	char * pText;// = new char[1];
-	int iTextLen;
-	int len2 = hfmCodec.Decode(pOutput, iOutputLen, &pText, &iTextLen);
-	TRACE("decode:%s\r\n", pText);
-
-	delete[] pOutput;
-	delete[] pText;
-	
-}
-
-debugging output:
-text:ADFHFAAAAHFGKKKKJJJJJJJJJJEEvkwwuuuuu
-Elem: A, D, E, F, G, H, J, K, k, u, v, w, 
-Len: 5, 1, 2, 3, 1, 2, 10, 4, 1, 5, 1, 2, 
-idx: 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 
-00 -- idx:6, cnt:10, code len:2, id:0 - huffman code
-010 -- idx:0, cnt:5, code len:3, id:1 - huffman code
-011 -- idx:7, cnt:4, code len:3, id:2 - huffman code
-100 -- idx:9, cnt:5, code len:3, id:3 - huffman code
-1010 -- idx:2, cnt:2, code len:4, id:4 - huffman code
-1011 -- idx:3, cnt:3, code len:4, id:5 - huffman code
-1100 -- idx:5, cnt:2, code len:4, id:6 - huffman code
-1101 -- idx:11, cnt:2, code len:4, id:7 - huffman code
-11100 -- idx:1, cnt:1, code len:5, id:8 - huffman code
-11101 -- idx:4, cnt:1, code len:5, id:9 - huffman code
-11110 -- idx:8, cnt:1, code len:5, id:10 - huffman code
-11111 -- idx:10, cnt:1, code len:5, id:11 - huffman code
-encode:0101110010111100101101001001001011001011111010110110110110000000000000000000010101010111111111011011101100100100100100
-text bit count: 296, after encoding:118 
-decode:ADFHFAAAAHFGKKKKJJJJJJJJJJEEvkwwuuuuu
-**/
+
+// Huffman.h : 头文件
+//
+
+
+#pragma once
+
+#include <deque>
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+#include <limits>
+#include <type_traits>
+#include <cstring>
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <shared_mutex>
+#include <unordered_map>
+#include "HuffmanLenLimit.h"
+#include "HuffmanThreadPool.h"
+#include "HuffmanSimd.h"
+using namespace std;
+
+// 非MFC环境下调试输出为空
+#ifndef TRACE
+#define TRACE(...)	((void)0)
+#endif
+
+// 强制内联: 多路解码展开出多份调用后, 编译器按代码增长估计可能不再内联热点函数
+#ifdef _MSC_VER
+#define HFM_FORCEINLINE		__forceinline
+#else
+#define HFM_FORCEINLINE		inline __attribute__((always_inline))
+#endif
+
+
+#define HFM_ARENA_BLOCK		(4*1024)	// 内存池首块大小
+#define HFM_ARENA_MAX_BLOCK	(1<<20)		// 内存池每块最大大小(单次申请更大时按需)
+
+/*内存池: 按块顺序分配, 不单独释放; Reset()整体回收并保留各块供下次使用
+  用于哈夫曼树节点和码字缓冲, 重建只需移动指针, 销毁只需一次Reset()*/
+class CHfmArena
+{
+public:
+	CHfmArena(size_t iBlockSize = HFM_ARENA_BLOCK)
+		:m_iBlockSize(max(iBlockSize, (size_t)64)), m_iBlock(0), m_iUsed(0)
+	{
+	}
+
+	void * Alloc(size_t iSize, size_t iAlign = alignof(max_align_t))
+	{
+		while(m_iBlock < m_vecBlocks.size())
+		{
+			uintptr_t base = (uintptr_t)m_vecBlocks[m_iBlock].get();
+			size_t pos = (size_t)(((base + m_iUsed + iAlign - 1) & ~(uintptr_t)(iAlign - 1)) - base);
+			if(pos + iSize <= m_vecSizes[m_iBlock])
+			{
+				m_iUsed = pos + iSize;
+				return (void *)(base + pos);
+			}
+			m_iBlock++;
+			m_iUsed = 0;
+		}
+
+		// 新块大小倍增, 之后的Reset()都会保留
+		size_t size = m_vecSizes.empty() ? m_iBlockSize : min(m_vecSizes.back() * 2, (size_t)HFM_ARENA_MAX_BLOCK);
+		size = max(size, iSize + iAlign);
+		m_vecBlocks.push_back(unique_ptr<char[]>(new char[size]));
+		m_vecSizes.push_back(size);
+		m_iBlock = m_vecBlocks.size() - 1;
+		m_iUsed = 0;
+
+		return Alloc(iSize, iAlign);
+	}
+
+	// 在池中构造对象, 对象不会被析构, 只用于析构函数无需调用的类型
+	template<typename T, typename... A>
+	T * New(A&&... args)
+	{
+		return new(Alloc(sizeof(T), alignof(T))) T(forward<A>(args)...);
+	}
+
+	template<typename T>
+	T * NewArray(size_t n)
+	{
+		return (T *)Alloc(sizeof(T) * max(n, (size_t)1), alignof(T));
+	}
+
+	// 回收全部分配, 保留内存
+	void Reset()
+	{
+		m_iBlock = 0;
+		m_iUsed = 0;
+	}
+
+	// 释放全部内存
+	void Release()
+	{
+		m_vecBlocks.clear();
+		m_vecSizes.clear();
+		Reset();
+	}
+
+	size_t GetCapacity()
+	{
+		size_t total = 0;
+		for(size_t i=0; i<m_vecSizes.size(); i++)
+		{
+			total += m_vecSizes[i];
+		}
+		return total;
+	}
+
+private:
+	CHfmArena(const CHfmArena &);
+	CHfmArena & operator=(const CHfmArena &);
+
+private:
+	size_t						m_iBlockSize;	// 首块大小
+	vector<unique_ptr<char[]>>	m_vecBlocks;
+	vector<size_t>				m_vecSizes;		// 各块大小
+	size_t						m_iBlock;		// 当前块
+	size_t						m_iUsed;		// 当前块已用字节数
+};
+
+
+/*哈夫曼编码*/
+class CHuffmanCode
+{
+public:
+	CHuffmanCode()
+		:m_CodeLen(0), m_pCode(nullptr)
+	{
+	}
+	CHuffmanCode(int codeLen)
+		:m_CodeLen(codeLen) 
+	{
+		m_pCode = new char[m_CodeLen];
+		for(int i=0; i<m_CodeLen; i++) 
+			m_pCode[i] = 0;
+	}
+	CHuffmanCode(int codeLen, CHuffmanCode& initVal)
+		:m_CodeLen(codeLen) 
+	{
+		m_pCode = new char[m_CodeLen];
+		for(int i=0; i<m_CodeLen; i++) 
+			m_pCode[i] = 0;
+
+		int start;
+		char * ptr = m_pCode + m_CodeLen - 1;
+
+		if(m_CodeLen >= initVal.m_CodeLen)
+		{
+			start = 0;
+		}
+		else
+		{
+			start = initVal.m_CodeLen - m_CodeLen;
+		}
+
+		for(int i=initVal.m_CodeLen-1; i>=start; i--)
+		{
+			*ptr = initVal.m_pCode[i];
+			ptr--;
+		}
+	}
+
+	~CHuffmanCode() 
+	{
+		if(m_pCode != nullptr) 
+		{
+			delete[] m_pCode;
+			m_pCode = nullptr;
+		}
+		m_CodeLen = 0;
+	}
+
+	CHuffmanCode& operator+=(char bit) 
+	{
+		for(int i=m_CodeLen-1; i>=0; i--)
+		{
+			m_pCode[i] += bit;
+
+			if(m_pCode[i] < 2)
+			{
+				break;
+			}
+
+			m_pCode[i] = 0;
+		}
+
+        return *this;
+    }
+
+	CHuffmanCode& operator<<=(int k) 
+	{
+		if(k >= m_CodeLen)
+		{
+			for(int i=m_CodeLen-1; i>=0; i--)
+			{
+				m_pCode[i] = 0;
+			}
+
+		}
+		else
+		{
+			for(int i=0; i<m_CodeLen-k; i++)
+			{
+				m_pCode[i] = m_pCode[i+k];
+			}
+			for(int i=m_CodeLen-k; i<m_CodeLen; i++)
+			{
+				m_pCode[i] = 0;
+			}
+		}
+
+        return *this;
+    }
+
+	// 码字缓冲从内存池分配, 随内存池回收
+	void GetCode(char ** ppCode, int * pCodeLen, CHfmArena & arena)
+	{
+		if(m_pCode != nullptr)
+		{
+			*ppCode = arena.NewArray<char>(m_CodeLen);
+			memcpy(*ppCode, m_pCode, m_CodeLen);
+			*pCodeLen = m_CodeLen;
+		}
+		else
+		{
+			*ppCode = nullptr;
+			*pCodeLen = 0;
+		}
+	}
+
+	void GetCode(char ** ppCode, int * pCodeLen)
+	{
+		if(m_pCode != nullptr)
+		{
+			*ppCode = new char[m_CodeLen];
+			memcpy(*ppCode, m_pCode, m_CodeLen);
+			*pCodeLen = m_CodeLen;
+		}
+		else
+		{
+			*ppCode = nullptr;
+			*pCodeLen = 0;
+		}
+	}
+
+	void SimpReset()
+	{
+		m_pCode = nullptr;
+		m_CodeLen = 0;
+	}
+
+	char * GetCodePtr()
+	{
+		return m_pCode;
+	}
+	int GetCodeLen()
+	{
+		return m_CodeLen;
+	}
+
+	void PaintSkin(CHuffmanCode& hfmcode)
+	{
+		if(this != &hfmcode)
+		{
+			if(m_pCode != nullptr)
+			{
+				delete[] m_pCode;
+			}
+			m_pCode = hfmcode.GetCodePtr();
+			m_CodeLen = hfmcode.GetCodeLen();
+			hfmcode.SimpReset();
+		}
+	}
+
+
+private:
+	char * m_pCode;
+	int m_CodeLen;
+};
+
+/*位流写入: 64位累加器, 高位在前(MSB-first)*/
+class CBitWriter
+{
+public:
+	CBitWriter(unsigned char * pBuf = nullptr)
+		:m_pCur(pBuf), m_ullAcc(0), m_iBits(0)
+	{
+	}
+
+	void Attach(unsigned char * pBuf)
+	{
+		m_pCur = pBuf;
+		m_ullAcc = 0;
+		m_iBits = 0;
+	}
+
+	// 写入一个码字, code右对齐, len <= 32
+	inline void PutBits(unsigned long long code, int len)
+	{
+		m_ullAcc = (m_ullAcc << len) | code;
+		m_iBits += len;
+
+		if(m_iBits >= 32)
+		{
+			m_iBits -= 32;
+			unsigned int w = (unsigned int)(m_ullAcc >> m_iBits);
+			m_pCur[0] = (unsigned char)(w >> 24);
+			m_pCur[1] = (unsigned char)(w >> 16);
+			m_pCur[2] = (unsigned char)(w >> 8);
+			m_pCur[3] = (unsigned char)w;
+			m_pCur += 4;
+		}
+	}
+
+	// 写入一个码字, len <= 64
+	inline void PutCode(unsigned long long code, int len)
+	{
+		if(len > 32)
+		{
+			PutBits(code >> 32, len - 32);
+			len = 32;
+			code &= 0xFFFFFFFFull;
+		}
+		PutBits(code, len);
+	}
+
+	// 写出累加器中的整字节, 不足一字节的位保留, 返回写入结束位置
+	unsigned char * FlushBytes()
+	{
+		while(m_iBits >= 8)
+		{
+			m_iBits -= 8;
+			*m_pCur++ = (unsigned char)(m_ullAcc >> m_iBits);
+		}
+		return m_pCur;
+	}
+
+	// 改变写入位置, 累加器中未写出的位保留
+	void SetPtr(unsigned char * pBuf){ m_pCur = pBuf; }
+
+	// 补齐最后一个字节, 返回写入结束位置
+	unsigned char * Flush()
+	{
+		while(m_iBits > 0)
+		{
+			if(m_iBits >= 8)
+			{
+				m_iBits -= 8;
+				*m_pCur++ = (unsigned char)(m_ullAcc >> m_iBits);
+			}
+			else
+			{
+				*m_pCur++ = (unsigned char)(m_ullAcc << (8 - m_iBits));
+				m_iBits = 0;
+			}
+		}
+		return m_pCur;
+	}
+
+private:
+	unsigned char * m_pCur;
+	unsigned long long m_ullAcc;	// 累加器, 低m_iBits位有效
+	int m_iBits;
+};
+
+// 读取8字节大端整数, 编译为一次读取加字节序转换
+inline unsigned long long HfmLoadBE64(const unsigned char * p)
+{
+	unsigned long long v;
+	memcpy(&v, p, 8);
+#if defined(_MSC_VER)
+	return _byteswap_uint64(v);
+#elif defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	return v;
+#else
+	return __builtin_bswap64(v);
+#endif
+}
+
+/*位流读取: 64位缓冲, 左对齐, 读过结尾补0*/
+class CBitReader
+{
+public:
+	CBitReader(const unsigned char * pBuf = nullptr, int iLen = 0)
+	{
+		Attach(pBuf, iLen);
+	}
+
+	void Attach(const unsigned char * pBuf, int iLen)
+	{
+		m_pBeg = pBuf;
+		m_pCur = pBuf;
+		m_pEnd = pBuf + iLen;
+		m_ullBuf = 0;
+		m_iBits = 0;
+		m_iPad = 0;
+		Refill();
+	}
+
+	// 补充缓冲, 之后至少有56位可用
+	inline void Refill()
+	{
+		if(m_pEnd - m_pCur >= 8)
+		{
+			unsigned long long v = HfmLoadBE64(m_pCur);
+			int n = (63 - m_iBits) >> 3;
+			m_ullBuf |= v >> m_iBits;
+			m_pCur += n;
+			m_iBits += n << 3;
+		}
+		else
+		{
+			while(m_iBits < 56)
+			{
+				unsigned long long byte = 0;
+				if(m_pCur < m_pEnd)
+				{
+					byte = *m_pCur++;
+				}
+				else
+				{
+					m_iPad++;
+				}
+				m_ullBuf |= byte << (56 - m_iBits);
+				m_iBits += 8;
+			}
+		}
+	}
+
+	// 预读n位, 1 <= n <= 32
+	inline unsigned int Peek(int n)
+	{
+		return (unsigned int)(m_ullBuf >> (64 - n));
+	}
+
+	// 预读n位, 1 <= n <= 56
+	inline unsigned long long Peek64(int n)
+	{
+		return m_ullBuf >> (64 - n);
+	}
+
+	inline void Skip(int n)
+	{
+		m_ullBuf <<= n;
+		m_iBits -= n;
+	}
+
+	inline int GetBit()
+	{
+		if(m_iBits == 0)
+		{
+			Refill();
+		}
+		int bit = (int)(m_ullBuf >> 63);
+		Skip(1);
+		return bit;
+	}
+
+	// 自Attach位置起已读取的位数
+	long long GetBitPos()
+	{
+		return (long long)(m_pCur - m_pBeg + m_iPad) * 8 - m_iBits;
+	}
+
+private:
+	const unsigned char * m_pBeg;
+	const unsigned char * m_pCur;
+	const unsigned char * m_pEnd;
+	unsigned long long m_ullBuf;	// 高m_iBits位有效
+	int m_iBits;
+	int m_iPad;						// 读过结尾补0的字节数
+};
+
+// 变长整数(每字节7位, 低位在前)
+inline unsigned char * HfmPutVarint(unsigned char * p, unsigned long long v)
+{
+	while(v >= 0x80)
+	{
+		*p++ = (unsigned char)(v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (unsigned char)v;
+	return p;
+}
+
+inline void HfmPutVarint(vector<unsigned char> & vec, unsigned long long v)
+{
+	unsigned char buf[10];
+	unsigned char * end = HfmPutVarint(buf, v);
+	vec.insert(vec.end(), buf, end);
+}
+
+// 读取失败(越界或超长)返回false
+inline bool HfmGetVarint(const unsigned char *& p, const unsigned char * end, unsigned long long & v)
+{
+	v = 0;
+	for(int shift=0; shift<64; shift+=7)
+	{
+		if(p >= end)
+		{
+			return false;
+		}
+		unsigned char b = *p++;
+		v |= (unsigned long long)(b & 0x7F) << shift;
+		if((b & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+// 码字低len位按位反转, 用于低位在前(LSB-first)的位流
+inline unsigned long long HfmReverseBits(unsigned long long code, int len)
+{
+	unsigned long long r = 0;
+	for(int i=0; i<len; i++)
+	{
+		r = (r << 1) | (code & 1);
+		code >>= 1;
+	}
+	return r;
+}
+
+/*由码长计算范式码字: 统计各码长的个数, 由递推 next[l] = (next[l-1] + count[l-1]) << 1 得各码长的首码字,
+  再按索引顺序依次分配, 即码字按(码长, 索引)顺序递增; bReverse为true时输出按位反转的码字*/
+inline void HfmCanonicCodes(const int * pLens, int size, unsigned long long * pCodes, bool bReverse = false)
+{
+	int count[65] = {0};
+	unsigned long long next[65];
+	int maxlen = 0;
+
+	for(int i=0; i<size; i++)
+	{
+		count[pLens[i]]++;
+		maxlen = max(maxlen, pLens[i]);
+	}
+
+	unsigned long long code = 0;
+	count[0] = 0;
+	for(int l=1; l<=maxlen; l++)
+	{
+		code = (code + count[l-1]) << 1;
+		next[l] = code;
+	}
+
+	for(int i=0; i<size; i++)
+	{
+		pCodes[i] = next[pLens[i]]++;
+	}
+
+	if(bReverse)
+	{
+		for(int i=0; i<size; i++)
+		{
+			pCodes[i] = HfmReverseBits(pCodes[i], pLens[i]);
+		}
+	}
+}
+
+#define HFM_TABLE_BITS			11		// 一级解码表默认位数
+#define HFM_TABLE_MAX_BITS		16		// 一级解码表最大位数
+#define HFM_SUBTABLE_MAX_BITS	12		// 二级解码表最大位数
+#define HFM_MAX_CODE_LEN		56		// 最大码长, 受CBitReader缓冲限制
+
+/*查表解码器: 由范式码长建表, 一次预读N位得到元素索引和码长
+  表项: 叶子 - (索引<<8)|码长; 二级表 - (偏移<<8)|0x80|二级位数; 0 - 非法码
+  二级表中0x80表示码长超出二级表, 按范式编码逐长度查找*/
+class CHuffmanDecTable
+{
+public:
+	CHuffmanDecTable()
+		:m_iTableBits(HFM_TABLE_BITS), m_iMaxLen(0)
+	{
+	}
+
+	void SetTableBits(int iBits)
+	{
+		m_iTableBits = max(1, min(iBits, HFM_TABLE_MAX_BITS));
+	}
+	int GetTableBits() const { return m_iTableBits; }
+	int GetMaxLen() const { return m_iMaxLen; }
+	// 一级表, 最长码长不超过一级表位数时可直接查表解出全部码字
+	const unsigned int * GetTable() const { return m_vecTable.empty() ? nullptr : &m_vecTable[0]; }
+	bool IsEmpty() const { return m_vecTable.empty(); }
+
+	void Clear()
+	{
+		m_vecTable.clear();
+		m_vecSorted.clear();
+		m_iMaxLen = 0;
+	}
+
+	// pLens[i] - 索引i的码长, 码字按(码长, 索引)顺序分配
+	bool Build(const int * pLens, int size);
+
+	// 解码一个元素, 返回元素索引, 非法码返回-1
+	// 调用前reader需有不少于m_iMaxLen位可用
+	HFM_FORCEINLINE int DecodeOne(CBitReader & reader) const
+	{
+		unsigned int e = m_vecTable[reader.Peek(m_iTableBits)];
+
+		if(e & 0x80)
+		{
+			int sub = e & 0x3F;
+			unsigned int rest = reader.Peek(m_iTableBits + sub) & ((1u << sub) - 1);
+			e = m_vecTable[(e >> 8) + rest];
+
+			if(e & 0x80)
+			{
+				// 只传入预读的位, 读取器不逃逸, 多路解码时可留在寄存器中
+				int len = 0;
+				int idx = DecodeSlow(reader.Peek64(m_iMaxLen), len);
+				if(idx >= 0)
+				{
+					reader.Skip(len);
+				}
+				return idx;
+			}
+		}
+
+		int len = e & 0x3F;
+		if(len == 0)
+		{
+			return -1;
+		}
+
+		reader.Skip(len);
+		return (int)(e >> 8);
+	}
+
+private:
+	int DecodeSlow(unsigned long long bits, int & len) const;
+
+private:
+	int m_iTableBits;						// 一级表位数
+	int m_iMaxLen;							// 最长码长
+	vector<unsigned int>	m_vecTable;		// 一级表, 其后接各二级表
+	vector<int>				m_vecSorted;	// 按(码长, 索引)排序的元素索引
+	vector<unsigned char>	m_vecPrefixLen;	// 建表用: 各一级前缀下的最长码长
+	unsigned long long		m_ullFirst[HFM_MAX_CODE_LEN+2];	// 各码长第一个码字
+	int						m_iCount[HFM_MAX_CODE_LEN+2];	// 各码长码字个数
+	int						m_iOffset[HFM_MAX_CODE_LEN+2];	// 各码长在m_vecSorted中的起始位置
+};
+
+inline bool CHuffmanDecTable::Build(const int * pLens, int size)
+{
+	Clear();
+
+	if(size <= 0)
+	{
+		return false;
+	}
+
+	for(int l=0; l<=HFM_MAX_CODE_LEN+1; l++)
+	{
+		m_iCount[l] = 0;
+	}
+
+	for(int i=0; i<size; i++)
+	{
+		int len = pLens[i];
+		if(len < 1 || len > HFM_MAX_CODE_LEN)
+		{
+			return false;
+		}
+		m_iCount[len]++;
+		m_iMaxLen = max(m_iMaxLen, len);
+	}
+
+	// 范式编码: 各码长第一个码字, 同时检查Kraft不等式
+	unsigned long long code = 0;
+	int offset = 0;
+	m_iCount[0] = 0;
+	for(int l=1; l<=m_iMaxLen; l++)
+	{
+		code = (code + m_iCount[l-1]) << 1;
+		m_ullFirst[l] = code;
+		m_iOffset[l] = offset;
+		offset += m_iCount[l];
+
+		if(m_iCount[l] > 0 && ((code + m_iCount[l] - 1) >> l) != 0)
+		{
+			return false;
+		}
+	}
+
+	m_vecSorted.resize(size);
+	int pos[HFM_MAX_CODE_LEN+2];
+	for(int l=1; l<=m_iMaxLen; l++)
+	{
+		pos[l] = m_iOffset[l];
+	}
+	for(int i=0; i<size; i++)
+	{
+		m_vecSorted[pos[pLens[i]]++] = i;
+	}
+
+	int N = m_iTableBits;
+	m_vecTable.assign((size_t)1 << N, 0);
+
+	// 长码: 统计每个一级前缀下的最长码长, 分配二级表
+	if(m_iMaxLen > N)
+	{
+		vector<unsigned char> & vecPrefixLen = m_vecPrefixLen;
+		vecPrefixLen.assign((size_t)1 << N, 0);
+		for(int l=N+1; l<=m_iMaxLen; l++)
+		{
+			for(int k=0; k<m_iCount[l]; k++)
+			{
+				unsigned long long c = m_ullFirst[l] + k;
+				vecPrefixLen[(size_t)(c >> (l - N))] = (unsigned char)l;
+			}
+		}
+
+		for(size_t p=0; p<vecPrefixLen.size(); p++)
+		{
+			if(vecPrefixLen[p] != 0)
+			{
+				int sub = min(vecPrefixLen[p] - N, HFM_SUBTABLE_MAX_BITS);
+				unsigned int off = (unsigned int)m_vecTable.size();
+				m_vecTable[p] = (off << 8) | 0x80 | (unsigned int)sub;
+				m_vecTable.resize(m_vecTable.size() + ((size_t)1 << sub), 0);
+			}
+		}
+	}
+
+	for(int l=1; l<=m_iMaxLen; l++)
+	{
+		for(int k=0; k<m_iCount[l]; k++)
+		{
+			unsigned long long c = m_ullFirst[l] + k;
+			unsigned int leaf = ((unsigned int)m_vecSorted[m_iOffset[l] + k] << 8) | (unsigned int)l;
+
+			if(l <= N)
+			{
+				size_t start = (size_t)c << (N - l);
+				size_t end = (size_t)(c + 1) << (N - l);
+				for(size_t j=start; j<end; j++)
+				{
+					m_vecTable[j] = leaf;
+				}
+			}
+			else
+			{
+				unsigned int e = m_vecTable[(size_t)(c >> (l - N))];
+				int sub = e & 0x3F;
+				size_t base = e >> 8;
+				int rest = l - N;
+				unsigned long long rem = c & ((1ull << rest) - 1);
+
+				if(rest <= sub)
+				{
+					size_t start = (size_t)rem << (sub - rest);
+					size_t end = (size_t)(rem + 1) << (sub - rest);
+					for(size_t j=start; j<end; j++)
+					{
+						m_vecTable[base + j] = leaf;
+					}
+				}
+				else
+				{
+					m_vecTable[base + (size_t)(rem >> (rest - sub))] = 0x80;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+// 超出二级表的长码, 按范式编码逐长度比较
+// bits: 右对齐的m_iMaxLen位
+inline int CHuffmanDecTable::DecodeSlow(unsigned long long bits, int & len) const
+{
+	for(int l=m_iTableBits+1; l<=m_iMaxLen; l++)
+	{
+		unsigned long long d = (bits >> (m_iMaxLen - l)) - m_ullFirst[l];
+		if(d < (unsigned long long)m_iCount[l])
+		{
+			len = l;
+			return m_vecSorted[m_iOffset[l] + (int)d];
+		}
+	}
+
+	return -1;
+}
+
+/*哈夫曼树的节点定义*/
+template <typename T>
+struct HuffmanNode
+{
+    HuffmanNode(T k,HuffmanNode<T>*l=nullptr,HuffmanNode<T>* r=nullptr,HuffmanNode<T>* p=nullptr)
+        :key(k), lchild(l), rchild(r), parent(p), code(-1), idx(-1){}
+    ~HuffmanNode(){};
+	int idx;					// 创建时节点索引, nodes和create()参数a[]中的索引, 解码时输出这个索引
+	char code;					// 节点哈夫曼编码
+    T key;                      //节点的权值
+    HuffmanNode<T>* parent;        //父节点
+    HuffmanNode<T>* lchild;        //节点左孩
+    HuffmanNode<T>* rchild;        //节点右孩
+};
+
+/*扁平解码树: 只保存解码需要的孩子和叶子, 连续存放
+  内部节点k的左右孩子为m_vecNodes[2k], [2k+1]; 表项 (下标<<1)|叶子标志, 叶子的下标为元素索引; 0为空(根不会是孩子)
+  表项不超过16位时用16位数组, 256种元素的树约1KB*/
+class CHfmFlatTree
+{
+public:
+	CHfmFlatTree():m_iInner(0){}
+
+	void Clear()
+	{
+		m_vec16.clear();
+		m_vec32.clear();
+		m_iInner = 0;
+	}
+	bool IsEmpty() const { return m_iInner == 0; }
+	int GetInnerNum() const { return m_iInner; }
+
+	// 由各元素的范式码字(右对齐, 高位在前)建树, 码字不满足前缀条件返回false
+	bool Build(const unsigned long long * pCodes, const int * pLens, int size);
+
+	// 逐位解码, pBits每个元素一位(0为左, 非0为右), 解出的元素追加到out; 遇到空孩子返回false
+	template<typename _BT, typename _EL, typename _VT>
+	bool Decode(const _BT * pBits, int iLen, const _EL * pElems, _VT & out) const
+	{
+		if(!m_vec16.empty())
+		{
+			return DecodeT(&m_vec16[0], pBits, iLen, pElems, out);
+		}
+		return DecodeT(&m_vec32[0], pBits, iLen, pElems, out);
+	}
+
+private:
+	template<typename IT, typename _BT, typename _EL, typename _VT>
+	static bool DecodeT(const IT * pNodes, const _BT * pBits, int iLen, const _EL * pElems, _VT & out)
+	{
+		unsigned int cur = 0;
+
+		for(int i=0; i<iLen; i++)
+		{
+			unsigned int e = pNodes[2 * cur + (pBits[i] != 0)];
+			if(e & 1)
+			{
+				out.push_back(pElems[e >> 1]);
+				cur = 0;
+			}
+			else if(e == 0)
+			{
+				return false;
+			}
+			else
+			{
+				cur = e >> 1;
+			}
+		}
+
+		return true;
+	}
+
+private:
+	vector<unsigned short>	m_vec16;	// 表项都不超过16位时使用
+	vector<unsigned int>	m_vec32;
+	vector<unsigned int>	m_vecWork;	// 建树用, 保留容量供下次使用
+	int						m_iInner;	// 内部节点数
+};
+
+inline bool CHfmFlatTree::Build(const unsigned long long * pCodes, const int * pLens, int size)
+{
+	Clear();
+
+	if(size <= 0 || size > (1 << 30))
+	{
+		return false;
+	}
+
+	vector<unsigned int> & vecNodes = m_vecWork;
+	vecNodes.assign(2, 0);
+	int inner = 1;
+
+	for(int i=0; i<size; i++)
+	{
+		unsigned long long code = pCodes[i];
+		int len = pLens[i];
+		unsigned int cur = 0;
+
+		if(len < 1 || len > 64)
+		{
+			return false;
+		}
+
+		for(int j=len-1; j>0; j--)
+		{
+			unsigned int bit = (unsigned int)(code >> j) & 1;
+			unsigned int & e = vecNodes[2 * cur + bit];
+			if(e == 0)
+			{
+				e = (unsigned int)inner << 1;
+				inner++;
+				vecNodes.push_back(0);
+				vecNodes.push_back(0);
+			}
+			else if(e & 1)
+			{
+				return false;
+			}
+
+			// push_back后e可能失效, 重新取
+			cur = vecNodes[2 * cur + bit] >> 1;
+		}
+
+		unsigned int & leaf = vecNodes[2 * cur + (unsigned int)(code & 1)];
+		if(leaf != 0)
+		{
+			return false;
+		}
+		leaf = ((unsigned int)i << 1) | 1;
+	}
+
+	// 只有一个元素时任一位都解出该元素, 与原树解码一致
+	if(size == 1)
+	{
+		vecNodes[0] = vecNodes[1] = 1;
+	}
+
+	m_iInner = inner;
+	if(2 * (long long)max(inner, size) <= 0x10000)
+	{
+		m_vec16.assign(vecNodes.begin(), vecNodes.end());
+	}
+	else
+	{
+		m_vec32.assign(vecNodes.begin(), vecNodes.end());
+	}
+
+	return true;
+}
+
+typedef char*	_CodePtr;
+
+template <typename T>
+class CHuffman
+{
+public:
+    void preOrder();              //前序遍历哈夫曼树
+    void inOrder();                  //中序遍历哈夫曼树
+    void postOrder();              //后序遍历哈夫曼树
+ 
+	// iLimit: 0 - 不限长, 大于0限长; iMode: HFM_LIMIT_PACKAGE_MERGE / HFM_LIMIT_KRAFT
+	bool CanonicCreat(T w[],int size, int iLimit = 0, int iMode = HFM_LIMIT_PACKAGE_MERGE);
+	// 只算码长和整数范式码字, 不生成字符形式的码字和解码树; getCode()/printCode()首次调用时再生成
+	bool CanonicCodes(T w[],int size, int iLimit = 0, int iMode = HFM_LIMIT_PACKAGE_MERGE);
+    void creat(T a[], int size);		//创建哈夫曼树
+	void CreatCodeLens(T w[], int size);	//不建树, 原地计算码长到m_vecCodeLens
+	static void CalcCodeLens(T A[], int n);	//Moffat-Katajainen原地计算码长, A[]为升序权值
+    void recreat();						//根据范式编码重建哈夫曼树, 同时建扁平解码树
+    void destroy();						//销毁哈夫曼树
+    void print();						//打印哈夫曼树
+    void printCode();						//打印哈夫曼树
+	bool getCode(int iIndex, char ** ppCode, int * plen);	// 指定索引的哈夫编码, 返回编码长度
+	bool getCode(int * plen);	// 返回编码长度
+	void Reset(){ destroy(); }
+	// 节点和码字缓冲使用外部内存池, nullptr - 用本对象的内存池
+	// 外部内存池由本对象独占使用, destroy()/ClearCodePtr()时回收; 可在多个依次使用的对象之间传递以复用内存
+	void SetArena(CHfmArena * pNodeArena, CHfmArena * pCodeArena = nullptr);
+	HuffmanNode<T>* GetRoot(){return root;}
+	const CHfmFlatTree & GetFlatTree(){return m_flat;}
+	const vector<int> & GetCodeLens(){return m_vecCodeLens;}
+	// 整数形式的范式码字, 右对齐; bReverse为true时取按位反转的码字, 用于低位在前的位流
+	const vector<unsigned long long> & GetIntCodes(bool bReverse = false);
+	void ClearCodePtr();
+
+    CHuffman();
+    virtual ~CHuffman(){ destroy(); ClearCodePtr(); TRACE("called destructor of class CHuffman!\r\n"); };
+ 
+private:
+    void preOrder(HuffmanNode<T>* pnode);
+    void inOrder(HuffmanNode<T>* pnode);
+    void postOrder(HuffmanNode<T>*pnode);
+    void print(HuffmanNode<T>*pnode);
+	// 返回编码长度
+	bool getCodeLen();
+	// 由整数范式码字生成字符形式的码字
+	void CanonicCodeByLens();
+	// 由整数范式码字生成字符形式的码字和解码树, 已有时不再生成
+	bool MakeCodeTree();
+
+protected:
+	vector<int>	m_vecCodeLens;		// 编码长度
+	vector<unsigned long long>	m_vecIntCodes;	// 范式码字, 右对齐, 与m_vecCodeLens对应
+	vector<unsigned long long>	m_vecRevCodes;	// 按位反转的范式码字, 首次取用时生成
+	_CodePtr * m_pCodePtr;
+ 
+private:
+    HuffmanNode<T>* root;			//哈夫曼树根节点
+	CHfmArena	m_nodeArena;			//节点内存池
+	CHfmArena	m_codeArena;			//码字内存池
+	CHfmArena *	m_pNodeArena;
+	CHfmArena *	m_pCodeArena;
+	CHfmFlatTree	m_flat;				//扁平解码树
+    vector<HuffmanNode<T>*> nodes;	//叶子节点, 清空时保留容量
+    vector<HuffmanNode<T>*> forest;	//森林
+	vector<int>	m_vecSortIdx;			//CreatCodeLens: 按权值排序的索引
+	vector<T>	m_vecWork;				//CreatCodeLens: 原地计算用的权值数组
+};
+
+template<typename T>
+void CHuffman<T>::ClearCodePtr()
+{
+	// 码字缓冲都在码字内存池中, 整体回收
+	m_pCodePtr = nullptr;
+	m_pCodeArena->Reset();
+	m_vecCodeLens.clear();
+	m_vecIntCodes.clear();
+	m_vecRevCodes.clear();
+}
+
+template<typename T>
+const vector<unsigned long long> & CHuffman<T>::GetIntCodes(bool bReverse)
+{
+	if(!bReverse)
+	{
+		return m_vecIntCodes;
+	}
+
+	if(m_vecRevCodes.size() != m_vecIntCodes.size())
+	{
+		m_vecRevCodes.resize(m_vecIntCodes.size());
+		for(size_t i=0; i<m_vecIntCodes.size(); i++)
+		{
+			m_vecRevCodes[i] = HfmReverseBits(m_vecIntCodes[i], m_vecCodeLens[i]);
+		}
+	}
+	return m_vecRevCodes;
+}
+
+template<typename T>
+void CHuffman<T>::printCode()						//打印哈夫曼树
+{
+	if(!MakeCodeTree())
+	{
+		return;
+	}
+
+	int size = m_vecCodeLens.size();
+
+	for(int i=0; i<size; i++)
+	{
+		int len = m_vecCodeLens[i];
+		_CodePtr codePtr = m_pCodePtr[i];
+
+		for(int j=0; j<len; j++)
+		{
+			TRACE("%d", codePtr[j]);
+		}
+		TRACE(" -- %d\r\n", i);
+	}
+}
+
+/*创建哈夫曼树*/
+template<typename T>
+CHuffman<T>::CHuffman()
+{
+	root = nullptr;
+	m_pCodePtr = nullptr;
+	m_pNodeArena = &m_nodeArena;
+	m_pCodeArena = &m_codeArena;
+}
+
+template<typename T>
+void CHuffman<T>::SetArena(CHfmArena * pNodeArena, CHfmArena * pCodeArena)
+{
+	destroy();
+	ClearCodePtr();
+	m_pNodeArena = (pNodeArena != nullptr) ? pNodeArena : &m_nodeArena;
+	m_pCodeArena = (pCodeArena != nullptr) ? pCodeArena : &m_codeArena;
+}
+
+// 返回编码长度
+template<typename T>
+bool CHuffman<T>::getCodeLen()
+{
+	int size = nodes.size();
+
+	if(size == 1)
+	{
+		m_vecCodeLens.push_back(1);
+	}
+	else
+	{
+		for(int j=0; j<size; j++)
+		{
+			int codeLen = 0;
+			HuffmanNode<T>* node = nodes[j];
+			while(node->parent != nullptr)
+			{
+				codeLen += 1;
+				node = node->parent;
+			}
+
+			m_vecCodeLens.push_back(codeLen);
+		}
+	}
+
+	return true;
+}
+
+template<typename T>
+void CHuffman<T>::CanonicCodeByLens()
+{
+	int size = m_vecCodeLens.size();
+
+	// 字符形式的码字(每个char一位)连续存放在一块缓冲中
+	int total = 0;
+	for(int i=0; i<size; i++)
+	{
+		total += m_vecCodeLens[i];
+	}
+
+	m_pCodePtr = m_pCodeArena->NewArray<_CodePtr>(size);
+	char * pBuf = m_pCodeArena->NewArray<char>(total);
+
+	for(int i=0; i<size; i++)
+	{
+		int len = m_vecCodeLens[i];
+		unsigned long long code = m_vecIntCodes[i];
+
+		m_pCodePtr[i] = pBuf;
+		for(int j=0; j<len; j++)
+		{
+			pBuf[j] = (char)((code >> (len - 1 - j)) & 1);
+			TRACE("%d", pBuf[j]);
+		}
+		pBuf += len;
+
+		TRACE(" -- idx:%d, code len:%d - huffman code\r\n", i, len);
+	}
+}
+
+
+template<typename T>
+bool CHuffman<T>::CanonicCreat(T w[],int size, int iLimit, int iMode)
+{
+	if(!CanonicCodes(w, size, iLimit, iMode))
+	{
+		return false;
+	}
+
+	// 范式编码重建哈夫曼树
+	return MakeCodeTree();
+}
+
+template<typename T>
+bool CHuffman<T>::CanonicCodes(T w[],int size, int iLimit, int iMode)
+{
+	// 重复使用时先释放上次的码表
+	destroy();
+	ClearCodePtr();
+
+	if(numeric_limits<T>::is_integer)
+	{
+		// 整数权值直接原地计算码长, 结果与creat()建树一致
+		CreatCodeLens(w,size);
+	}
+	else
+	{
+		creat(w,size);
+
+		// 返回编码长度
+		getCodeLen();
+		destroy();
+	}
+
+	if(iLimit > 0)
+	{
+		// 限长失败只可能是iLimit位不足以容纳size个元素
+		bool bok = HfmLimitCodeLens(w, size, iLimit, iMode, &m_vecCodeLens[0]);
+		if(!bok)
+			return false;
+	}
+
+	// 整数范式码字: 码长相同按索引顺序分配, 保证只凭码长即可重建同样的范式编码
+	m_vecIntCodes.resize(size);
+	HfmCanonicCodes(&m_vecCodeLens[0], size, &m_vecIntCodes[0]);
+	return true;
+}
+
+template<typename T>
+bool CHuffman<T>::MakeCodeTree()
+{
+	if(root != nullptr)
+	{
+		return true;
+	}
+	if(m_vecCodeLens.empty() || m_vecIntCodes.size() != m_vecCodeLens.size())
+	{
+		return false;
+	}
+
+	if(m_pCodePtr == nullptr)
+	{
+		CanonicCodeByLens();
+	}
+	recreat();
+	return true;
+}
+
+//根据编码重建哈夫曼树
+template<typename T>
+void CHuffman<T>::recreat()
+{
+	int size = m_vecCodeLens.size();
+
+	if(size == 1)
+	{
+		root = m_pNodeArena->New<HuffmanNode<T>>((T)0,nullptr,nullptr,nullptr); 
+		root->idx = 0;
+		root->code = 0;
+	}
+	else
+	{
+		root = m_pNodeArena->New<HuffmanNode<T>>((T)0,nullptr,nullptr,nullptr); 
+
+		for(int i=0; i<size; i++)
+		{
+			unsigned long long code = m_vecIntCodes[i];
+			int codeLen = m_vecCodeLens[i];
+
+			HuffmanNode<T>* node = root;
+
+			for(int j=0; j<codeLen; j++)
+			{
+				int bit = (int)(code >> (codeLen - 1 - j)) & 1;
+
+				if(bit == 0)
+				{
+					if(node->lchild == nullptr)
+					{
+						HuffmanNode<T> * newnode = m_pNodeArena->New<HuffmanNode<T>>((T)0,nullptr,nullptr,node); 
+						newnode->code = 0;
+						node->lchild = newnode;
+						if(j == (codeLen - 1))
+						{
+							newnode->idx = i;
+							nodes.push_back(newnode);
+						}
+					}
+
+					node = node->lchild;
+				}
+				else
+				{
+					if(node->rchild == nullptr)
+					{
+						HuffmanNode<T> * newnode = m_pNodeArena->New<HuffmanNode<T>>((T)0,nullptr,nullptr,node); 
+
+						newnode->code = 1;
+						node->rchild = newnode;
+
+						if(j == (codeLen - 1))
+						{
+							newnode->idx = i;
+							nodes.push_back(newnode);
+						}
+					}
+
+					node = node->rchild;
+				}
+			}
+
+		}
+	}
+
+	m_flat.Build(&m_vecIntCodes[0], &m_vecCodeLens[0], size);
+}
+
+/*Moffat-Katajainen原地计算码长
+  A[0..n-1]为升序排列的权值, 完成后A[i]为对应的码长(n为1时码长为0)
+  第一遍从左到右合并, A[]中依次存放内部节点权值和父节点位置;
+  第二遍从右到左算内部节点深度; 第三遍从右到左按深度分配叶子码长*/
+template<typename T>
+void CHuffman<T>::CalcCodeLens(T A[], int n)
+{
+	if(n <= 0)
+	{
+		return;
+	}
+	if(n == 1)
+	{
+		A[0] = 0;
+		return;
+	}
+
+	int root = 0;
+	int leaf = 2;
+	int next;
+
+	A[0] += A[1];
+	for(next=1; next<n-1; next++)
+	{
+		// 第一个子节点, 权值相同时优先取叶子
+		if(leaf >= n || A[root] < A[leaf])
+		{
+			A[next] = A[root];
+			A[root++] = (T)next;
+		}
+		else
+		{
+			A[next] = A[leaf++];
+		}
+
+		// 第二个子节点
+		if(leaf >= n || (root < next && A[root] < A[leaf]))
+		{
+			A[next] += A[root];
+			A[root++] = (T)next;
+		}
+		else
+		{
+			A[next] += A[leaf++];
+		}
+	}
+
+	A[n-2] = 0;
+	for(next=n-3; next>=0; next--)
+	{
+		A[next] = A[(int)A[next]] + 1;
+	}
+
+	int avbl = 1;
+	int used = 0;
+	int dpth = 0;
+	root = n - 2;
+	next = n - 1;
+	while(avbl > 0)
+	{
+		while(root >= 0 && (int)A[root] == dpth)
+		{
+			used++;
+			root--;
+		}
+		while(avbl > used)
+		{
+			A[next--] = (T)dpth;
+			avbl--;
+		}
+		avbl = 2 * used;
+		dpth++;
+		used = 0;
+	}
+}
+
+// 不分配节点, 码长直接写入m_vecCodeLens; 工作数组保留容量, 重复调用不再分配内存
+template<typename T>
+void CHuffman<T>::CreatCodeLens(T w[], int size)
+{
+	m_vecSortIdx.resize(size);
+	m_vecWork.resize(size);
+	m_vecCodeLens.resize(size);
+
+	for(int i=0; i<size; i++)
+	{
+		m_vecSortIdx[i] = i;
+	}
+
+	// 权值相同按索引排序, 与creat()的稳定排序一致
+	sort(m_vecSortIdx.begin(), m_vecSortIdx.end(), [w](int a, int b){return w[a] < w[b] || (!(w[b] < w[a]) && a < b);});
+
+	for(int i=0; i<size; i++)
+	{
+		m_vecWork[i] = w[m_vecSortIdx[i]];
+	}
+
+	CalcCodeLens(&m_vecWork[0], size);
+
+	for(int i=0; i<size; i++)
+	{
+		m_vecCodeLens[m_vecSortIdx[i]] = max(1, (int)m_vecWork[i]);
+	}
+}
+
+/*创建哈夫曼树*/
+template<typename T>
+void CHuffman<T>::creat(T a[],int size)
+{
+    for (int i = 0; i < size; i++) //每个节点都作为一个森林
+    {
+        //为初始序列的元素构建节点。每个节点作为一棵树加入森林中。
+        HuffmanNode<T>* ptr = m_pNodeArena->New<HuffmanNode<T>>(a[i],nullptr,nullptr,nullptr);  
+		ptr->idx = i;
+        nodes.push_back(ptr);
+        forest.push_back(ptr);
+		
+    }
+
+	if(size == 1)
+	{
+		forest[0]->code = 0;
+		root = forest.front();
+		forest.clear();
+		return;
+	}
+
+	// 叶子只排序一次(稳定排序, 权值相同保持原索引顺序)
+	stable_sort(forest.begin(), forest.end(), [](HuffmanNode<T>* a, HuffmanNode<T>*b){return a->key < b->key; });
+
+	// 双队列合并: forest为排好序的叶子, merged为依次生成的新节点(权值单调不减)
+	// 权值相同时优先取叶子, 与每轮对整个森林稳定排序的结果一致
+	vector<HuffmanNode<T>*> merged;
+	merged.reserve(size - 1);
+	size_t leaf = 0;
+	size_t head = 0;
+
+	for (int i = 0; i < size - 1; i++)
+	{
+		HuffmanNode<T>* pick[2];
+		for (int k = 0; k < 2; k++)
+		{
+			if (leaf < forest.size() && (head >= merged.size() || !(merged[head]->key < forest[leaf]->key)))
+			{
+				pick[k] = forest[leaf++];
+			}
+			else
+			{
+				pick[k] = merged[head++];
+			}
+		}
+
+		HuffmanNode<T>*node = m_pNodeArena->New<HuffmanNode<T>>(pick[0]->key + pick[1]->key, pick[0], pick[1]); //构建新节点
+		pick[0]->parent = node;
+		pick[1]->parent = node;
+		pick[0]->code = 0;
+		pick[1]->code = 1;
+		merged.push_back(node);  //新节点加入森林中
+	}
+
+	forest.clear();
+	root = merged.back();
+}
+
+/*打印哈夫曼树*/
+template<typename T>
+void CHuffman<T>::print()
+{
+	print(root);
+}
+
+/*打印哈夫曼树*/
+template<typename T>
+void CHuffman<T>::print(HuffmanNode<T>* pnode)
+{
+    if (pnode != nullptr)
+    {
+		TRACE("当前结点: %.2f. ", (float)pnode->key);
+        if (pnode->lchild != nullptr)
+            TRACE("它的左孩子节点为： %.2f.", (float)pnode->lchild->key);
+        else 
+			TRACE("它没有左孩子.");
+        if (pnode->rchild != nullptr)
+            TRACE("它的右孩子节点为： %.2f.", (float)pnode->rchild->key);
+        else 
+			TRACE("它没有右孩子.");
+		TRACE("\r\n");
+
+        print(pnode->lchild);
+        print(pnode->rchild);
+    }
+}
+
+//销毁哈夫曼树
+template<typename T>
+void CHuffman<T>::destroy()
+{
+	// 节点都在节点内存池中, 整体回收
+	m_pNodeArena->Reset();
+
+	this->nodes.clear();
+	root = nullptr;
+	m_flat.Clear();
+}
+
+// ppCode - 指定索引的哈夫编码, len - 返回编码长度
+template<typename T>
+bool CHuffman<T>::getCode(int iIndex, char ** ppCode, int * plen)
+{
+	if(!MakeCodeTree())
+	{	
+		return false;
+	}
+
+	int size = nodes.size();
+	if(iIndex >= size)
+	{
+		return false;
+	}
+
+	if(size == 1)
+	{
+		*ppCode = new char[1];
+		(*ppCode)[0] = nodes[0]->code;
+		*plen = 1;
+	}
+	else
+	{
+		int codeLen = 0;
+		HuffmanNode<T>* node = nodes[iIndex];
+		while(node->parent != nullptr)
+		{
+			codeLen += 1;
+			node = node->parent;
+		}
+
+		char * pcode = new char[codeLen];
+		node = nodes[iIndex];
+		for(int i=codeLen-1; i>=0; i--)
+		{
+			pcode[i] = node->code;
+			node = node->parent;
+		}
+
+		*ppCode = pcode;
+		*plen = codeLen;
+	}
+
+	return true;
+}
+
+
+/*码长表编码(类似DEFLATE): 码长序列做游程编码, 再对其做一层哈夫曼编码
+  码长符号: 1..HFM_MAX_CODE_LEN - 码长; HFM_CL_REP_S - 重复前一码长3..6次(2位);
+  HFM_CL_REP_L - 重复前一码长7..134次(7位)
+  码长码限长15, 其码长用4位保存; 不划算时直接用6位保存每个码长*/
+#define HFM_CL_REP_S	(HFM_MAX_CODE_LEN + 1)
+#define HFM_CL_REP_L	(HFM_MAX_CODE_LEN + 2)
+#define HFM_CL_SYMS		(HFM_MAX_CODE_LEN + 3)
+
+class CCodeLenCoder
+{
+public:
+	// 分析码长序列, 选择保存方式, 返回所需位数
+	long long Prepare(const int * pLens, int size)
+	{
+		m_pLens = pLens;
+		m_iSize = size;
+		m_vecSyms.clear();
+		m_vecExtra.clear();
+
+		for(int i=0; i<size; )
+		{
+			int len = pLens[i];
+			m_vecSyms.push_back(len);
+			m_vecExtra.push_back(0);
+
+			int run = 0;
+			while(i + 1 + run < size && pLens[i + 1 + run] == len && run < 134)
+			{
+				run++;
+			}
+
+			if(run >= 7)
+			{
+				m_vecSyms.push_back(HFM_CL_REP_L);
+				m_vecExtra.push_back(run - 7);
+			}
+			else if(run >= 3)
+			{
+				m_vecSyms.push_back(HFM_CL_REP_S);
+				m_vecExtra.push_back(run - 3);
+			}
+			else
+			{
+				run = 0;
+			}
+
+			i += 1 + run;
+		}
+
+		// 码长码
+		int cnts[HFM_CL_SYMS] = {0};
+		for(size_t i=0; i<m_vecSyms.size(); i++)
+		{
+			cnts[m_vecSyms[i]]++;
+		}
+
+		vector<int> & vecUsed = m_vecUsed;
+		vector<int> & vecWeights = m_vecWeights;
+		vecUsed.clear();
+		vecWeights.clear();
+		for(int k=0; k<HFM_CL_SYMS; k++)
+		{
+			m_iClLens[k] = 0;
+			if(cnts[k] > 0)
+			{
+				vecUsed.push_back(k);
+				vecWeights.push_back(cnts[k]);
+			}
+		}
+
+		// 只需码长, 与CanonicCreat(..., 15)的码长相同
+		m_huff.CreatCodeLens(&vecWeights[0], (int)vecWeights.size());
+		m_vecLens = m_huff.GetCodeLens();
+		HfmLimitCodeLens(&vecWeights[0], (int)vecWeights.size(), 15, HFM_LIMIT_PACKAGE_MERGE, &m_vecLens[0]);
+		const vector<int> & vecLens = m_vecLens;
+
+		m_iClNum = vecUsed.back() + 1;
+		for(size_t k=0; k<vecUsed.size(); k++)
+		{
+			m_iClLens[vecUsed[k]] = vecLens[k];
+		}
+
+		long long llHuffBits = 6 + 4 * m_iClNum;
+		for(size_t i=0; i<m_vecSyms.size(); i++)
+		{
+			int sym = m_vecSyms[i];
+			llHuffBits += m_iClLens[sym];
+			llHuffBits += (sym == HFM_CL_REP_S) ? 2 : ((sym == HFM_CL_REP_L) ? 7 : 0);
+		}
+
+		long long llRawBits = 6LL * size;
+		m_bHuff = (llHuffBits < llRawBits);
+		m_llBits = m_bHuff ? llHuffBits : llRawBits;
+
+		return m_llBits;
+	}
+
+	bool IsHuff(){ return m_bHuff; }
+	// Prepare()算出的位数
+	long long GetBits(){ return m_llBits; }
+
+	void Write(CBitWriter & writer)
+	{
+		if(!m_bHuff)
+		{
+			for(int i=0; i<m_iSize; i++)
+			{
+				writer.PutBits(m_pLens[i], 6);
+			}
+			return;
+		}
+
+		unsigned long long codes[HFM_CL_SYMS];
+		CanonicCodesSparse(m_iClLens, m_iClNum, codes);
+
+		writer.PutBits(m_iClNum, 6);
+		for(int k=0; k<m_iClNum; k++)
+		{
+			writer.PutBits(m_iClLens[k], 4);
+		}
+
+		for(size_t i=0; i<m_vecSyms.size(); i++)
+		{
+			int sym = m_vecSyms[i];
+			writer.PutBits(codes[sym], m_iClLens[sym]);
+			if(sym == HFM_CL_REP_S)
+			{
+				writer.PutBits(m_vecExtra[i], 2);
+			}
+			else if(sym == HFM_CL_REP_L)
+			{
+				writer.PutBits(m_vecExtra[i], 7);
+			}
+		}
+	}
+
+	// 读取size个码长, 失败返回false; pTable: 码长码的解码表, 可由调用方提供以复用内存
+	static bool Read(CBitReader & reader, bool bHuff, int * pLens, int size, CHuffmanDecTable * pTable = nullptr)
+	{
+		if(!bHuff)
+		{
+			for(int i=0; i<size; i++)
+			{
+				reader.Refill();
+				pLens[i] = (int)reader.Peek(6);
+				reader.Skip(6);
+				if(pLens[i] < 1 || pLens[i] > HFM_MAX_CODE_LEN)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		reader.Refill();
+		int iClNum = (int)reader.Peek(6);
+		reader.Skip(6);
+		if(iClNum > HFM_CL_SYMS)
+		{
+			return false;
+		}
+
+		// 只对出现的码长符号建表
+		int iLens[HFM_CL_SYMS];
+		int iSyms[HFM_CL_SYMS];
+		int iUsed = 0;
+		for(int k=0; k<iClNum; k++)
+		{
+			reader.Refill();
+			int len = (int)reader.Peek(4);
+			reader.Skip(4);
+			if(len > 0)
+			{
+				iLens[iUsed] = len;
+				iSyms[iUsed] = k;
+				iUsed++;
+			}
+		}
+
+		CHuffmanDecTable local;
+		CHuffmanDecTable & table = (pTable != nullptr) ? *pTable : local;
+		table.SetTableBits(8);
+		if(!table.Build(iLens, iUsed))
+		{
+			return false;
+		}
+
+		for(int i=0; i<size; )
+		{
+			reader.Refill();
+			int idx = table.DecodeOne(reader);
+			if(idx < 0)
+			{
+				return false;
+			}
+
+			int sym = iSyms[idx];
+			int run = 1;
+			if(sym == HFM_CL_REP_S || sym == HFM_CL_REP_L)
+			{
+				if(i == 0)
+				{
+					return false;
+				}
+				int bits = (sym == HFM_CL_REP_S) ? 2 : 7;
+				run = (int)reader.Peek(bits) + ((sym == HFM_CL_REP_S) ? 3 : 7);
+				reader.Skip(bits);
+				sym = pLens[i-1];
+			}
+
+			if(sym < 1 || i + run > size)
+			{
+				return false;
+			}
+
+			for(int k=0; k<run; k++)
+			{
+				pLens[i++] = sym;
+			}
+		}
+
+		return true;
+	}
+
+private:
+	// 码长为0的符号不分配码字
+	static void CanonicCodesSparse(const int * pLens, int size, unsigned long long * pCodes)
+	{
+		int iLens[HFM_CL_SYMS];
+		unsigned long long codes[HFM_CL_SYMS];
+		int n = 0;
+		for(int k=0; k<size; k++)
+		{
+			if(pLens[k] > 0)
+			{
+				iLens[n++] = pLens[k];
+			}
+		}
+
+		HfmCanonicCodes(iLens, n, codes);
+
+		n = 0;
+		for(int k=0; k<size; k++)
+		{
+			pCodes[k] = (pLens[k] > 0) ? codes[n++] : 0;
+		}
+	}
+
+private:
+	const int *		m_pLens;
+	int				m_iSize;
+	vector<int>		m_vecSyms;			// 游程编码后的码长符号
+	vector<int>		m_vecExtra;			// 重复符号的附加位
+	vector<int>		m_vecUsed;			// 出现的码长符号
+	vector<int>		m_vecWeights;		// 码长符号的出现次数
+	vector<int>		m_vecLens;			// 码长符号的码长
+	CHuffman<int>	m_huff;				// 计算码长码, 对象复用时保留内存
+	int				m_iClLens[HFM_CL_SYMS];	// 码长码的码长
+	int				m_iClNum;			// 保存的码长码个数
+	bool			m_bHuff;			// 是否用哈夫曼编码保存
+	long long		m_llBits;			// 保存码长表所需位数
+};
+
+#define HFM_STAT_MIN_CHUNK	(64*1024)	// 并行统计时每个线程至少分到的元素数
+#define HFM_STAT_FLAT_CHUNK	(1<<30)		// 平坦计数表每次最多累加的元素数, 32位分组计数不会溢出
+
+template<typename T>
+class CElemStat
+{
+public:
+	typedef pair <T, long long> Elem_Pair;
+
+	int Stat(T * pText, long long size);
+	// 在已有统计上累加, 可分多次统计大于内存的数据
+	int Add(T * pText, long long size);
+	// 多线程统计: 分段统计后合并, 结果与Stat()相同; iThreads: 0 - 线程池全部线程
+	// pPool: 执行统计的线程池, nullptr - CHfmThreadPool::Default()
+	int StatParallel(T * pText, long long size, int iThreads = 0, CHfmThreadPool * pPool = nullptr);
+	// 累加另一统计结果
+	int Merge(CElemStat<T> & other);
+	int GetElemNum();
+	// 计数为64位, 输出到W类型(int / long long等)的数组
+	template<typename W>
+	int GetStat(T * pElems, W * pCnts, int size);
+	void Clear();
+
+	CElemStat(){}
+    virtual ~CElemStat(){TRACE("called destructor of class CElemStat!\r\n");}
+ 
+private:
+	unordered_map<T, long long>	m_mapStat;		// 元素值到计数, GetStat时按元素值排序
+	vector<Elem_Pair>			m_vecSorted;	// 排序用, 保留容量
+};
+
+template<typename T>
+void CElemStat<T>::Clear()
+{
+	if(!m_mapStat.empty())
+		m_mapStat.clear();
+}
+
+template<typename T>
+int CElemStat<T>::Stat(T * pText, long long size)
+{
+	Clear();
+	return Add(pText, size);
+}
+
+template<typename T>
+int CElemStat<T>::Add(T * pText, long long size)
+{
+	for(long long i=0; i<size; i++)
+	{
+		typename unordered_map<T, long long>::iterator iter = m_mapStat.find(pText[i]);
+		if(iter == m_mapStat.end())
+		{
+			m_mapStat.insert(Elem_Pair(pText[i], 1));
+		}
+		else
+		{
+			iter->second++;
+		}
+	}
+
+	return m_mapStat.size();
+}
+
+// 分段数, 输入太小时不值得并行
+inline int HfmStatParts(long long size, int iThreads, CHfmThreadPool & pool)
+{
+	int parts = (iThreads > 0) ? iThreads : pool.GetThreadNum();
+	return (int)max(1LL, min((long long)parts, size / HFM_STAT_MIN_CHUNK));
+}
+
+template<typename T>
+int CElemStat<T>::StatParallel(T * pText, long long size, int iThreads, CHfmThreadPool * pPool)
+{
+	CHfmThreadPool & pool = pPool ? *pPool : CHfmThreadPool::Default();
+	int parts = HfmStatParts(size, iThreads, pool);
+	if(parts <= 1)
+	{
+		return Stat(pText, size);
+	}
+
+	vector<CElemStat<T>> vecPart(parts);
+	pool.ParallelFor(parts, [&](int k){
+		long long beg = size * k / parts;
+		long long end = size * (k + 1) / parts;
+		vecPart[k].Stat(pText + beg, end - beg);
+	});
+
+	Clear();
+	for(int k=0; k<parts; k++)
+	{
+		Merge(vecPart[k]);
+	}
+
+	return GetElemNum();
+}
+
+template<typename T>
+int CElemStat<T>::Merge(CElemStat<T> & other)
+{
+	typename unordered_map<T, long long>::iterator iter = other.m_mapStat.begin();
+	while(iter != other.m_mapStat.end())
+	{
+		m_mapStat[iter->first] += iter->second;
+		iter++;
+	}
+
+	return m_mapStat.size();
+}
+
+template<typename T>
+template<typename W>
+int CElemStat<T>::GetStat(T * pElems, W * pCnts, int size)
+{
+	int rsize = m_mapStat.size();
+	if(rsize <= size)
+	{
+		// 输出按元素值升序
+		m_vecSorted.assign(m_mapStat.begin(), m_mapStat.end());
+		sort(m_vecSorted.begin(), m_vecSorted.end(), [](const Elem_Pair & a, const Elem_Pair & b){return a.first < b.first;});
+
+		for(int i=0; i<rsize; i++)
+		{
+			pElems[i] = m_vecSorted[i].first;
+			pCnts[i] = (W)m_vecSorted[i].second;
+		}
+
+		return rsize;
+	}
+	else
+	{
+		return 0;
+	}
+}
+
+template<typename T>
+int CElemStat<T>::GetElemNum()
+{
+	int rsize = m_mapStat.size();
+	return rsize;
+}
+
+/*单字节/双字节元素的统计: 以元素值为下标直接计数到平坦数组
+  K组计数表交错累加, 连续相同元素不会反复读写同一计数器, 最后合并; GetStat按元素大小顺序输出
+  计数数组跨消息保留, 另记出现过的元素值, 清除和输出只涉及这些项, 小消息的开销与平坦数组大小无关*/
+template<typename T, int K>
+class CElemStatFlat
+{
+public:
+	typedef typename make_unsigned<T>::type _UT;
+	enum { N = 1 << (8 * sizeof(T)) };
+
+	int Stat(T * pText, long long size);
+	int Add(T * pText, long long size);
+	int StatParallel(T * pText, long long size, int iThreads = 0, CHfmThreadPool * pPool = nullptr);
+	int Merge(CElemStatFlat<T, K> & other);
+	int GetElemNum(){ return m_iElemNum; }
+	template<typename W>
+	int GetStat(T * pElems, W * pCnts, int size);
+	void Clear();
+
+	CElemStatFlat():m_iElemNum(0){}
+	virtual ~CElemStatFlat(){TRACE("called destructor of class CElemStat!\r\n");}
+
+private:
+	// 计数数组只分配、清零一次
+	void Alloc()
+	{
+		if(m_vecCnt.empty())
+		{
+			m_vecCnt.assign(N, 0);
+		}
+	}
+
+private:
+	vector<long long>	m_vecCnt;	// 合并后的计数, 以无符号元素值为下标
+	vector<_UT>		m_vecKeys;		// 计数非0的元素值, 无序
+	vector<int>		m_vecPart;		// K组交错计数表, 每次最多累加HFM_STAT_FLAT_CHUNK个元素; 只清零一次, 合并时逐项清零
+	int				m_iElemNum;
+};
+
+template<typename T, int K>
+void CElemStatFlat<T, K>::Clear()
+{
+	// 只复位出现过的元素, 保留计数数组
+	for(size_t i=0; i<m_vecKeys.size(); i++)
+	{
+		m_vecCnt[m_vecKeys[i]] = 0;
+	}
+	m_vecKeys.clear();
+	m_iElemNum = 0;
+}
+
+template<typename T, int K>
+int CElemStatFlat<T, K>::Stat(T * pText, long long size)
+{
+	Clear();
+	return Add(pText, size);
+}
+
+template<typename T, int K>
+int CElemStatFlat<T, K>::Add(T * pText, long long size)
+{
+	Alloc();
+	long long * pCnt = &m_vecCnt[0];
+
+	for(long long pos=0; pos<size; pos+=HFM_STAT_FLAT_CHUNK)
+	{
+		int len = (int)min((long long)HFM_STAT_FLAT_CHUNK, size - pos);
+		const _UT * p = (const _UT *)(pText + pos);
+
+		// 元素数不及K组计数表大小时, 合并K组表的开销超过交错的收益, 直接计数
+		if(len < K * N)
+		{
+			for(int i=0; i<len; i++)
+			{
+				if(pCnt[p[i]]++ == 0)
+				{
+					m_vecKeys.push_back(p[i]);
+				}
+			}
+			continue;
+		}
+
+		if(m_vecPart.empty())
+		{
+			m_vecPart.assign((size_t)K * N, 0);
+		}
+
+		int * pPart = &m_vecPart[0];
+		int i = 0;
+
+		for(; i+K<=len; i+=K)
+		{
+			for(int k=0; k<K; k++)
+			{
+				pPart[k * N + p[i + k]]++;
+			}
+		}
+		for(; i<len; i++)
+		{
+			pPart[p[i]]++;
+		}
+
+		for(int j=0; j<N; j++)
+		{
+			long long cnt = 0;
+			for(int k=0; k<K; k++)
+			{
+				cnt += pPart[k * N + j];
+				pPart[k * N + j] = 0;
+			}
+			if(cnt != 0 && pCnt[j] == 0)
+			{
+				m_vecKeys.push_back((_UT)j);
+			}
+			pCnt[j] += cnt;
+		}
+	}
+
+	m_iElemNum = (int)m_vecKeys.size();
+	return m_iElemNum;
+}
+
+template<typename T, int K>
+int CElemStatFlat<T, K>::StatParallel(T * pText, long long size, int iThreads, CHfmThreadPool * pPool)
+{
+	CHfmThreadPool & pool = pPool ? *pPool : CHfmThreadPool::Default();
+	int parts = HfmStatParts(size, iThreads, pool);
+	if(parts <= 1)
+	{
+		return Stat(pText, size);
+	}
+
+	vector<CElemStatFlat<T, K>> vecPart(parts);
+	pool.ParallelFor(parts, [&](int k){
+		long long beg = size * k / parts;
+		long long end = size * (k + 1) / parts;
+		vecPart[k].Stat(pText + beg, end - beg);
+	});
+
+	Clear();
+	for(int k=0; k<parts; k++)
+	{
+		Merge(vecPart[k]);
+	}
+
+	return m_iElemNum;
+}
+
+template<typename T, int K>
+int CElemStatFlat<T, K>::Merge(CElemStatFlat<T, K> & other)
+{
+	Alloc();
+
+	for(size_t i=0; i<other.m_vecKeys.size(); i++)
+	{
+		_UT v = other.m_vecKeys[i];
+		if(m_vecCnt[v] == 0)
+		{
+			m_vecKeys.push_back(v);
+		}
+		m_vecCnt[v] += other.m_vecCnt[v];
+	}
+
+	m_iElemNum = (int)m_vecKeys.size();
+	return m_iElemNum;
+}
+
+template<typename T, int K>
+template<typename W>
+int CElemStatFlat<T, K>::GetStat(T * pElems, W * pCnts, int size)
+{
+	if(m_iElemNum > size || m_vecCnt.empty())
+	{
+		return 0;
+	}
+
+	// 元素少时只对出现过的元素排序, 否则按元素值扫描整个数组
+	if(m_iElemNum * 16 < N)
+	{
+		sort(m_vecKeys.begin(), m_vecKeys.end(), [](_UT a, _UT b){return (T)a < (T)b;});
+		for(int k=0; k<m_iElemNum; k++)
+		{
+			pElems[k] = (T)m_vecKeys[k];
+			pCnts[k] = (W)m_vecCnt[m_vecKeys[k]];
+		}
+		return m_iElemNum;
+	}
+
+	int k = 0;
+	for(int j=0; j<N; j++)
+	{
+		// 按T的大小顺序(有符号类型从最小负数开始), 与map的顺序一致
+		T elem = (T)((long long)numeric_limits<T>::min() + j);
+		long long cnt = m_vecCnt[(_UT)elem];
+		if(cnt != 0)
+		{
+			pElems[k] = elem;
+			pCnts[k] = (W)cnt;
+			k++;
+		}
+	}
+
+	return k;
+}
+
+template<> class CElemStat<char> : public CElemStatFlat<char, 4> {};
+template<> class CElemStat<signed char> : public CElemStatFlat<signed char, 4> {};
+template<> class CElemStat<unsigned char> : public CElemStatFlat<unsigned char, 4> {};
+template<> class CElemStat<short> : public CElemStatFlat<short, 2> {};
+template<> class CElemStat<unsigned short> : public CElemStatFlat<unsigned short, 2> {};
+
+// 编码输出格式
+enum
+{
+	HFM_FMT_BITCHAR = 0,	// 每个char保存一位编码(原格式)
+	HFM_FMT_PACKED,			// 紧凑位流, 每字节8位, 高位在前
+	HFM_FMT_FRAME,			// 自描述帧, 含元素表和码长, 解码不依赖编码端状态
+	HFM_FMT_ADAPTIVE,		// 自适应哈夫曼, 单遍编码, 无帧头
+};
+
+/*帧格式:
+  [类型 1字节][元素个数 varint][元素种类数 varint][元素表][码长表 + 数据 位流]
+  元素表: 首元素zigzag varint, 之后为与前一元素差值-1的varint; 单字节元素可用256位图
+分块帧:
+  [类型 1字节][元素个数 varint][块数 varint][块索引][块帧]..., 每块为独立的哈夫曼编码帧
+  块索引: 每块[块帧字节数 varint][块元素个数 varint], 解码端据此算出各块的输入位置和输出位置, 各块可并行解码*/
+#define HFM_FRAME_HUFFMAN		0x01	// 帧类型: 哈夫曼编码
+#define HFM_FRAME_BLOCKS		0x02	// 帧类型: 分块编码
+#define HFM_FRAME_TYPE_MASK		0x0F
+#define HFM_FRAME_CL_HUFF		0x10	// 码长表经哈夫曼编码
+#define HFM_FRAME_SYM_BITMAP	0x20	// 元素表为位图
+#define HFM_FRAME_MULTI			0x40	// 数据分为多路交错子流
+
+/*多路子流: 第i个元素写入第i%N路, 各路独立成流, 解码时N路可同时进行; N为2的幂
+  元素表之后为[路数N varint][第1..N-1路字节数 varint], 位流依次为: 码长表 + 第0路, 第1路, ..., 第N-1路*/
+#define HFM_MAX_STREAMS			16		// 最大子流路数
+#define HFM_STREAM_GROUP		4		// 标量多路解码每组同时解码的路数, 更多路同时解码时寄存器不足
+#define HFM_STREAM_CHUNK		4096	// 多路编码时按块逐路写入, 每块元素数, 为HFM_MAX_STREAMS的倍数
+
+/*转义: 只给出现次数最多的K种元素建码, 元素表只含这K种, 码长表末尾多一项转义码
+  其余元素写为转义码 + 元素原值(sizeof(_EL)*8位); 元素种类很多(16位/32位的ID流等)时码表和解码表仍可留在缓存中
+  含转义码的帧不分子流*/
+#define HFM_FRAME_ESCAPE		0x80	// 码表末项为转义码
+
+// 读转义元素的原值(sizeof(_EL)*8位), 每次最多取32位
+template<typename _EL>
+inline _EL HfmReadRaw(CBitReader & reader)
+{
+	typedef typename make_unsigned<_EL>::type _UT;
+	unsigned long long v = 0;
+
+	for(int bits=8*(int)sizeof(_EL); bits>0; )
+	{
+		int k = min(bits, 32);
+		reader.Refill();
+		v = (v << k) | reader.Peek(k);
+		reader.Skip(k);
+		bits -= k;
+	}
+
+	return (_EL)(_UT)v;
+}
+
+/*流格式:
+  [类型 1字节]{[帧长度 varint][哈夫曼编码帧]}...[0], 以长度0结束
+  每帧最多一块元素, 编码端只缓存一块输入, 解码端只缓存一帧输入, 内存占用与数据总长无关*/
+#define HFM_FRAME_STREAM		0x03	// 帧类型: 流
+#define HFM_STREAM_BLOCK		(1<<20)	// 流式编码未设块大小时的默认块大小
+#define HFM_STREAM_MAX_FRAME	(1<<30)	// 流式解码接受的最大帧长度
+
+// 写元素表: 首元素zigzag varint, 之后为与前一元素差值-1的varint; 单字节元素差值表比位图长时改用位图
+template<typename _EL>
+void HfmWriteElems(const _EL * pElems, int n, vector<unsigned char> & vecHdr)
+{
+	size_t start = vecHdr.size();
+
+	long long v0 = (long long)pElems[0];
+	HfmPutVarint(vecHdr, ((unsigned long long)v0 << 1) ^ (unsigned long long)(v0 >> 63));
+	for(int i=1; i<n; i++)
+	{
+		HfmPutVarint(vecHdr, (unsigned long long)((long long)pElems[i] - (long long)pElems[i-1] - 1));
+	}
+
+	if(sizeof(_EL) == 1 && vecHdr.size() - start > 32)
+	{
+		vecHdr.resize(start);
+		vecHdr.resize(start + 32, 0);
+		for(int i=0; i<n; i++)
+		{
+			int bit = (int)((long long)pElems[i] - (long long)numeric_limits<_EL>::min());
+			vecHdr[start + (bit >> 3)] |= (unsigned char)(1 << (bit & 7));
+		}
+		vecHdr[0] |= HFM_FRAME_SYM_BITMAP;
+	}
+}
+
+// 读元素表到vecElems
+template<typename _EL>
+bool HfmReadElems(const unsigned char *& p, const unsigned char * end, unsigned char type, int n, vector<_EL> & vecElems)
+{
+	vecElems.resize(n);
+
+	if(type & HFM_FRAME_SYM_BITMAP)
+	{
+		if(sizeof(_EL) != 1 || end - p < 32)
+		{
+			return false;
+		}
+
+		int k = 0;
+		for(int bit=0; bit<256; bit++)
+		{
+			if(p[bit >> 3] & (1 << (bit & 7)))
+			{
+				if(k >= n)
+				{
+					return false;
+				}
+				vecElems[k++] = (_EL)((long long)numeric_limits<_EL>::min() + bit);
+			}
+		}
+		p += 32;
+
+		return k == n;
+	}
+
+	unsigned long long v = 0;
+	if(!HfmGetVarint(p, end, v))
+	{
+		return false;
+	}
+
+	long long prev = (long long)(v >> 1) ^ -(long long)(v & 1);
+	vecElems[0] = (_EL)prev;
+
+	for(int i=1; i<n; i++)
+	{
+		if(!HfmGetVarint(p, end, v))
+		{
+			return false;
+		}
+		prev = prev + (long long)v + 1;
+		vecElems[i] = (_EL)prev;
+	}
+
+	return true;
+}
+
+/*自适应哈夫曼(FGK): 每编码/解码一个元素即更新树, 单遍完成, 不需统计和帧头
+  节点按兄弟性质连续存放: 下标0为根, 权值随下标不增, 兄弟占(2k-1, 2k), NYT(未出现元素)总在末尾
+  交换节点只交换两个位置的内容, 各位置的父节点不变; 权值相同的节点连续, 构成权值块, 块首下标按块记录
+位流: 已出现元素 - 叶子码字; 新元素 - NYT码字 + 0 + 元素原值(sizeof(_EL)*8位); 结束 - NYT码字 + 1*/
+#define HFM_ADAPT_NYT		(-2)		// 节点idx: NYT
+#define HFM_ADAPT_BUF		(64*1024)	// 自适应编解码的输出缓冲大小
+
+// 自适应哈夫曼树的节点, 与HuffmanNode对应, 以下标代替指针
+struct HfmAdaptNode
+{
+	long long key;			// 权值
+	int parent;				// 父节点下标, 随位置固定
+	int lchild;				// 左孩子下标, 右孩子为lchild+1; 叶子为0
+	int idx;				// 叶子的元素索引; 内部节点-1; NYT为HFM_ADAPT_NYT
+	int block;				// 所在权值块(权值相同的连续节点)的编号, 随位置固定
+};
+
+template<typename _EL>
+class CHuffmanAdaptive
+{
+public:
+	typedef typename make_unsigned<_EL>::type _UT;
+	typedef function<bool(const char * pData, size_t iLen)>	_ByteSink;
+	typedef function<bool(const _EL * pElems, size_t iLen)>	_ElemSink;
+
+	CHuffmanAdaptive(){ Reset(); }
+
+	// 流式编码: 每次输入后立即写出已完成的整字节, 不缓存输入
+	bool EncodeBegin(const _ByteSink & sink);
+	bool EncodeFeed(const _EL * pText, size_t iTextLen);
+	bool EncodeFinish();					// 写结束码并补齐最后一个字节
+	// 流式解码: 输入可在任意位置断开
+	bool DecodeBegin(const _ElemSink & sink);
+	bool DecodeFeed(const char * pData, size_t iDataLen);
+	bool DecodeFinish();					// 已读到结束码且其后没有多余数据返回true
+
+	void Reset();
+
+private:
+	enum { RAW_BITS = 8 * sizeof(_EL), FLAT_SIZE = 1 << (sizeof(_EL) <= 2 ? RAW_BITS : 0) };
+	// 解码状态
+	enum { DEC_WALK = 0, DEC_FLAG, DEC_RAW, DEC_END, DEC_ERROR };
+
+	// 元素索引, 未出现返回-1
+	inline int Find(_EL e)
+	{
+		if(sizeof(_EL) <= 2)
+		{
+			return m_vecIdx.empty() ? -1 : m_vecIdx[(_UT)e];
+		}
+		typename unordered_map<_EL, int>::iterator iter = m_mapIdx.find(e);
+		return (iter == m_mapIdx.end()) ? -1 : iter->second;
+	}
+	int AddElem(_EL e);
+	void Update(int pos);
+	void Increment(int pos, int cnt);
+	int NewBlock(int leader);
+	void SwapNodes(int i, int j);
+	void PutPath(int pos);
+	bool Reserve(int iBits);
+	bool Drain();
+	void Resolve();
+
+private:
+	vector<HfmAdaptNode>	m_vecNodes;		// 按兄弟性质排列的节点
+	vector<_EL>				m_vecElems;		// 元素索引到元素值
+	vector<int>				m_vecLeaf;		// 元素索引到叶子下标
+	vector<int>				m_vecIdx;		// 单字节/双字节元素: 元素值到索引的平坦表
+	unordered_map<_EL, int>	m_mapIdx;		// 其他元素: 元素值到索引
+	int						m_iNyt;			// NYT下标
+	vector<int>				m_vecBlkLeader;	// 权值块编号到块首(块内最小下标)
+	vector<int>				m_vecBlkFree;	// 空闲的权值块编号
+
+	_ByteSink				m_byteSink;
+	_ElemSink				m_elemSink;
+	vector<unsigned char>	m_vecBuf;		// 编码输出缓冲
+	CBitWriter				m_writer;
+	vector<unsigned int>	m_vecPath;		// 超过32位的码字, 自叶子向上每32位一组
+	vector<_EL>				m_vecOut;		// 解码输出缓冲
+	int						m_iState;		// 解码状态
+	int						m_iCur;			// 解码当前节点
+	int						m_iRawBits;		// 已读取的元素原值位数
+	unsigned long long		m_ullRaw;		// 已读取的元素原值
+	bool					m_bExtra;		// 结束码之后有多余数据
+};
+
+template<typename _EL>
+void CHuffmanAdaptive<_EL>::Reset()
+{
+	HfmAdaptNode root = {0, -1, 0, HFM_ADAPT_NYT, 0};
+	m_vecNodes.assign(1, root);
+	m_vecBlkLeader.assign(1, 0);
+	m_vecBlkFree.clear();
+	m_vecElems.clear();
+	m_vecLeaf.clear();
+	m_vecIdx.clear();
+	m_mapIdx.clear();
+	m_iNyt = 0;
+	m_iState = DEC_WALK;
+	m_iCur = 0;
+	m_iRawBits = 0;
+	m_ullRaw = 0;
+	m_bExtra = false;
+}
+
+// NYT分裂为内部节点, 左孩子为新叶子, 右孩子为新的NYT; 返回新叶子下标
+template<typename _EL>
+int CHuffmanAdaptive<_EL>::AddElem(_EL e)
+{
+	int idx = (int)m_vecElems.size();
+	int p = m_iNyt;
+
+	// 新节点权值为0, 与NYT同块
+	int b = m_vecNodes[p].block;
+	HfmAdaptNode leaf = {0, p, 0, idx, b};
+	HfmAdaptNode nyt = {0, p, 0, HFM_ADAPT_NYT, b};
+	m_vecNodes.push_back(leaf);
+	m_vecNodes.push_back(nyt);
+	m_vecNodes[p].lchild = p + 1;
+	m_vecNodes[p].idx = -1;
+	m_iNyt = p + 2;
+
+	m_vecElems.push_back(e);
+	m_vecLeaf.push_back(p + 1);
+	if(sizeof(_EL) <= 2)
+	{
+		if(m_vecIdx.empty())
+		{
+			m_vecIdx.assign(FLAT_SIZE, -1);
+		}
+		m_vecIdx[(_UT)e] = idx;
+	}
+	else
+	{
+		m_mapIdx[e] = idx;
+	}
+
+	return p + 1;
+}
+
+// 交换两个位置的子树, 权值相同
+template<typename _EL>
+void CHuffmanAdaptive<_EL>::SwapNodes(int i, int j)
+{
+	HfmAdaptNode & a = m_vecNodes[i];
+	HfmAdaptNode & b = m_vecNodes[j];
+	swap(a.lchild, b.lchild);
+	swap(a.idx, b.idx);
+
+	int pos[2] = {i, j};
+	for(int k=0; k<2; k++)
+	{
+		HfmAdaptNode & n = m_vecNodes[pos[k]];
+		if(n.idx >= 0)
+		{
+			m_vecLeaf[n.idx] = pos[k];
+		}
+		else
+		{
+			m_vecNodes[n.lchild].parent = pos[k];
+			m_vecNodes[n.lchild + 1].parent = pos[k];
+		}
+	}
+}
+
+// 自pos起到根, 各节点先与所在权值块的块首交换, 再加1; 块首由块编号直接取得, 每个节点O(1)
+// 块首为父节点时(NYT的兄弟)不交换, 该节点紧随父节点之后, 与父节点一起加1
+template<typename _EL>
+void CHuffmanAdaptive<_EL>::Update(int pos)
+{
+	int cnt = 1;
+
+	while(pos > 0)
+	{
+		int parent = m_vecNodes[pos].parent;
+		int leader = m_vecBlkLeader[m_vecNodes[pos].block];
+
+		if(leader == parent)
+		{
+			pos = parent;
+			cnt = 2;
+			continue;
+		}
+		if(leader != pos)
+		{
+			SwapNodes(pos, leader);
+			pos = leader;
+		}
+
+		Increment(pos, cnt);
+		cnt = 1;
+		pos = m_vecNodes[pos].parent;
+	}
+
+	Increment(0, cnt);
+}
+
+// 块首pos起cnt个节点权值加1: 移出原块, 并入前面权值大1的块或自成一块; 权值仍随下标不增
+template<typename _EL>
+void CHuffmanAdaptive<_EL>::Increment(int pos, int cnt)
+{
+	int b = m_vecNodes[pos].block;
+	long long w = m_vecNodes[pos].key;
+	int next = pos + cnt;
+
+	if(next < (int)m_vecNodes.size() && m_vecNodes[next].key == w)
+	{
+		m_vecBlkLeader[b] = next;
+	}
+	else
+	{
+		m_vecBlkFree.push_back(b);
+	}
+
+	int nb = (pos > 0 && m_vecNodes[pos - 1].key == w + 1) ? m_vecNodes[pos - 1].block : NewBlock(pos);
+	for(int k=0; k<cnt; k++)
+	{
+		m_vecNodes[pos + k].key = w + 1;
+		m_vecNodes[pos + k].block = nb;
+	}
+}
+
+// 新权值块, 块编号优先复用
+template<typename _EL>
+int CHuffmanAdaptive<_EL>::NewBlock(int leader)
+{
+	if(m_vecBlkFree.empty())
+	{
+		m_vecBlkLeader.push_back(leader);
+		return (int)m_vecBlkLeader.size() - 1;
+	}
+
+	int b = m_vecBlkFree.back();
+	m_vecBlkFree.pop_back();
+	m_vecBlkLeader[b] = leader;
+	return b;
+}
+
+// 写出自根到pos的码字: 奇数下标为左孩子(0), 偶数下标为右孩子(1)
+template<typename _EL>
+void CHuffmanAdaptive<_EL>::PutPath(int pos)
+{
+	// 自叶子向上每32位一组, 组内低位在叶子一侧
+	m_vecPath.clear();
+	unsigned int code = 0;
+	int len = 0;
+	while(pos > 0)
+	{
+		code |= (unsigned int)((pos & 1) ^ 1) << len;
+		pos = m_vecNodes[pos].parent;
+		if(++len == 32)
+		{
+			m_vecPath.push_back(code);
+			code = 0;
+			len = 0;
+		}
+	}
+
+	if(len > 0)
+	{
+		m_writer.PutBits(code, len);
+	}
+	for(size_t i=m_vecPath.size(); i>0; i--)
+	{
+		m_writer.PutBits(m_vecPath[i - 1], 32);
+	}
+}
+
+// 写出缓冲中已完成的字节
+template<typename _EL>
+bool CHuffmanAdaptive<_EL>::Drain()
+{
+	unsigned char * pBase = &m_vecBuf[0];
+	unsigned char * pEnd = m_writer.FlushBytes();
+	m_writer.SetPtr(pBase);
+
+	return pEnd == pBase || m_byteSink((const char *)pBase, pEnd - pBase);
+}
+
+// 保证缓冲还能写入iBits位
+template<typename _EL>
+bool CHuffmanAdaptive<_EL>::Reserve(int iBits)
+{
+	size_t need = (size_t)iBits / 8 + 16;
+	unsigned char * pCur = m_writer.FlushBytes();
+
+	if((size_t)(pCur - &m_vecBuf[0]) + need <= m_vecBuf.size())
+	{
+		return true;
+	}
+	if(!Drain())
+	{
+		return false;
+	}
+	if(need > m_vecBuf.size())
+	{
+		m_vecBuf.resize(need);
+		m_writer.SetPtr(&m_vecBuf[0]);
+	}
+
+	return true;
+}
+
+template<typename _EL>
+bool CHuffmanAdaptive<_EL>::EncodeBegin(const _ByteSink & sink)
+{
+	Reset();
+	m_byteSink = sink;
+	m_vecBuf.resize(HFM_ADAPT_BUF);
+	m_writer.Attach(&m_vecBuf[0]);
+
+	return true;
+}
+
+template<typename _EL>
+bool CHuffmanAdaptive<_EL>::EncodeFeed(const _EL * pText, size_t iTextLen)
+{
+	for(size_t i=0; i<iTextLen; i++)
+	{
+		int idx = Find(pText[i]);
+		int pos = (idx >= 0) ? m_vecLeaf[idx] : m_iNyt;
+
+		// 码字最长为节点数
+		if(!Reserve((int)m_vecNodes.size() + 1 + RAW_BITS))
+		{
+			return false;
+		}
+
+		PutPath(pos);
+		if(idx < 0)
+		{
+			m_writer.PutBits(0, 1);
+			m_writer.PutCode((unsigned long long)(_UT)pText[i], RAW_BITS);
+			pos = AddElem(pText[i]);
+		}
+
+		Update(pos);
+	}
+
+	return Drain();
+}
+
+template<typename _EL>
+bool CHuffmanAdaptive<_EL>::EncodeFinish()
+{
+	if(!Reserve((int)m_vecNodes.size() + 1))
+	{
+		return false;
+	}
+
+	PutPath(m_iNyt);
+	m_writer.PutBits(1, 1);
+
+	unsigned char * pBase = &m_vecBuf[0];
+	unsigned char * pEnd = m_writer.Flush();
+	m_writer.SetPtr(pBase);
+
+	return pEnd == pBase || m_byteSink((const char *)pBase, pEnd - pBase);
+}
+
+template<typename _EL>
+bool CHuffmanAdaptive<_EL>::DecodeBegin(const _ElemSink & sink)
+{
+	Reset();
+	m_elemSink = sink;
+	m_vecOut.clear();
+	m_vecOut.reserve(HFM_ADAPT_BUF);
+	Resolve();
+
+	return true;
+}
+
+// 走到叶子时输出元素并更新树, 回到根; 走到NYT时转为读标志位
+template<typename _EL>
+void CHuffmanAdaptive<_EL>::Resolve()
+{
+	for(;;)
+	{
+		const HfmAdaptNode & n = m_vecNodes[m_iCur];
+		if(n.idx >= 0)
+		{
+			m_vecOut.push_back(m_vecElems[n.idx]);
+			Update(m_iCur);
+			m_iCur = 0;
+		}
+		else
+		{
+			if(n.idx == HFM_ADAPT_NYT)
+			{
+				m_iState = DEC_FLAG;
+			}
+			return;
+		}
+	}
+}
+
+template<typename _EL>
+bool CHuffmanAdaptive<_EL>::DecodeFeed(const char * pData, size_t iDataLen)
+{
+	const unsigned char * p = (const unsigned char *)pData;
+
+	for(size_t i=0; i<iDataLen && m_iState != DEC_ERROR; i++)
+	{
+		// 结束码所在字节之后不应再有数据
+		if(m_iState == DEC_END)
+		{
+			m_bExtra = true;
+			m_iState = DEC_ERROR;
+			break;
+		}
+
+		for(int b=7; b>=0 && m_iState != DEC_END; b--)
+		{
+			int bit = (p[i] >> b) & 1;
+
+			if(m_iState == DEC_WALK)
+			{
+				m_iCur = m_vecNodes[m_iCur].lchild + bit;
+				Resolve();
+			}
+			else if(m_iState == DEC_FLAG)
+			{
+				if(bit)
+				{
+					m_iState = DEC_END;
+				}
+				else
+				{
+					m_iState = DEC_RAW;
+					m_iRawBits = 0;
+					m_ullRaw = 0;
+				}
+			}
+			else
+			{
+				m_ullRaw = (m_ullRaw << 1) | (unsigned int)bit;
+				if(++m_iRawBits == RAW_BITS)
+				{
+					_EL e = (_EL)(_UT)m_ullRaw;
+					if(Find(e) >= 0)
+					{
+						m_iState = DEC_ERROR;
+						break;
+					}
+					m_vecOut.push_back(e);
+					Update(AddElem(e));
+					m_iCur = 0;
+					m_iState = DEC_WALK;
+					Resolve();
+				}
+			}
+		}
+
+		if(m_vecOut.size() >= HFM_ADAPT_BUF)
+		{
+			if(!m_elemSink(&m_vecOut[0], m_vecOut.size()))
+			{
+				m_iState = DEC_ERROR;
+			}
+			m_vecOut.clear();
+		}
+	}
+
+	if(m_iState == DEC_ERROR)
+	{
+		return false;
+	}
+
+	if(!m_vecOut.empty())
+	{
+		bool bok = m_elemSink(&m_vecOut[0], m_vecOut.size());
+		m_vecOut.clear();
+		if(!bok)
+		{
+			m_iState = DEC_ERROR;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template<typename _EL>
+bool CHuffmanAdaptive<_EL>::DecodeFinish()
+{
+	return m_iState == DEC_END && !m_bExtra;
+}
+
+/*码书帧: [类型 1字节][元素个数 varint][数据 位流], 码表来自预训练的码书, 帧内不含元素表和码长
+码书: [类型 1字节][元素种类数 varint][元素表][码长表 位流], 码长表末尾为转义码的码长
+  码书之外的元素写为转义码 + 元素原值(sizeof(_EL)*8位)*/
+#define HFM_FRAME_CODEBOOK		0x04	// 帧类型: 码书编码
+#define HFM_FRAME_BOOK			0x05	// 序列化的码书
+
+/*预训练码书: 离线统计样本语料, 生成并保存码表; 编解码大量相似的小消息时不必每次统计、建树
+  码书建好后只读, 可供多个编解码器在多个线程中同时使用*/
+template<typename _EL>
+class CHuffmanCodebook
+{
+public:
+	typedef typename make_unsigned<_EL>::type _UT;
+
+	CHuffmanCodebook():m_iEsc(-1){}
+
+	// 累加统计样本, 可多次调用; 返回元素种类数
+	int Train(_EL * pText, long long size){ return m_stat.Add(pText, size); }
+	// 由统计结果建码表, 转义码权值为1; iLimit/iMode同CHuffmanCodec::SetCodeLenLimit
+	bool Build(int iLimit = 0, int iMode = HFM_LIMIT_PACKAGE_MERGE);
+	void Clear();
+	bool IsEmpty() const { return m_iEsc < 0; }
+	int GetElemNum() const { return m_iEsc; }
+
+	// 序列化, 输出由new[]分配; 返回长度
+	int Serialize(char ** ppOutput, int * pOutputLen) const;
+	bool Load(const char * pData, int iDataLen);
+
+	// 编码数据位数
+	long long GetBits(const _EL * pText, int iTextLen) const;
+	// 单个元素编码的最大位数(转义元素为转义码长加原值位数)
+	int GetMaxBits() const
+	{
+		int maxlen = 0;
+		for(size_t i=0; i<m_vecLens.size(); i++)
+		{
+			maxlen = max(maxlen, m_vecLens[i]);
+		}
+		return maxlen + RAW_BITS;
+	}
+	void Write(CBitWriter & writer, const _EL * pText, int iTextLen) const;
+	// 解码count个元素, 非法码返回false
+	template<typename _OT>
+	bool Read(CBitReader & reader, int count, _OT * pOut) const;
+
+private:
+	bool Setup();
+	// 元素在码表中的索引, 不在码书中返回转义码索引
+	inline int Find(_EL e) const
+	{
+		if(sizeof(_EL) <= 2)
+		{
+			return m_vecIdx[(_UT)e];
+		}
+		typename unordered_map<_EL, int>::const_iterator iter = m_mapIdx.find(e);
+		return (iter == m_mapIdx.end()) ? m_iEsc : iter->second;
+	}
+
+private:
+	enum { RAW_BITS = 8 * sizeof(_EL), FLAT_SIZE = 1 << (sizeof(_EL) <= 2 ? RAW_BITS : 0) };
+
+	CElemStat<_EL>				m_stat;			// 训练统计
+	vector<_EL>					m_vecElems;		// 元素表, 升序
+	vector<int>					m_vecLens;		// 码长, 末项为转义码
+	vector<unsigned long long>	m_vecCodes;		// 范式码字, 右对齐
+	vector<int>					m_vecIdx;		// 单字节/双字节元素: 元素值到索引的平坦表
+	unordered_map<_EL, int>		m_mapIdx;		// 其他元素: 元素值到索引
+	CHuffmanDecTable			m_decTable;		// 解码表
+	int							m_iEsc;			// 转义码索引, 即码书元素个数; -1为未建
+};
+
+template<typename _EL>
+void CHuffmanCodebook<_EL>::Clear()
+{
+	m_stat.Clear();
+	m_vecElems.clear();
+	m_vecLens.clear();
+	m_vecCodes.clear();
+	m_vecIdx.clear();
+	m_mapIdx.clear();
+	m_decTable.Clear();
+	m_iEsc = -1;
+}
+
+template<typename _EL>
+bool CHuffmanCodebook<_EL>::Build(int iLimit, int iMode)
+{
+	int n = m_stat.GetElemNum();
+	vector<long long> vecWeights(n + 1);
+
+	m_vecElems.resize(n);
+	if(n > 0)
+	{
+		m_stat.GetStat(&m_vecElems[0], &vecWeights[0], n);
+	}
+	vecWeights[n] = 1;
+
+	CHuffman<long long> huff;
+	huff.CreatCodeLens(&vecWeights[0], n + 1);
+	m_vecLens = huff.GetCodeLens();
+
+	if(iLimit > 0 && !HfmLimitCodeLens(&vecWeights[0], n + 1, iLimit, iMode, &m_vecLens[0]))
+	{
+		return false;
+	}
+
+	return Setup();
+}
+
+// 由元素表和码长生成码字、解码表和索引表
+template<typename _EL>
+bool CHuffmanCodebook<_EL>::Setup()
+{
+	int n = (int)m_vecElems.size();
+	m_iEsc = -1;
+
+	if(!m_decTable.Build(&m_vecLens[0], n + 1))
+	{
+		return false;
+	}
+
+	m_vecCodes.resize(n + 1);
+	HfmCanonicCodes(&m_vecLens[0], n + 1, &m_vecCodes[0]);
+
+	m_mapIdx.clear();
+	if(sizeof(_EL) <= 2)
+	{
+		m_vecIdx.assign(FLAT_SIZE, n);
+		for(int i=0; i<n; i++)
+		{
+			m_vecIdx[(_UT)m_vecElems[i]] = i;
+		}
+	}
+	else
+	{
+		m_mapIdx.reserve(n);
+		for(int i=0; i<n; i++)
+		{
+			m_mapIdx[m_vecElems[i]] = i;
+		}
+	}
+
+	m_iEsc = n;
+	return true;
+}
+
+template<typename _EL>
+int CHuffmanCodebook<_EL>::Serialize(char ** ppOutput, int * pOutputLen) const
+{
+	if(IsEmpty())
+	{
+		return -1;
+	}
+
+	int n = m_iEsc;
+	vector<unsigned char> vecHdr;
+	vecHdr.push_back(HFM_FRAME_BOOK);
+	HfmPutVarint(vecHdr, (unsigned long long)n);
+	if(n > 0)
+	{
+		HfmWriteElems(&m_vecElems[0], n, vecHdr);
+	}
+
+	CCodeLenCoder clcoder;
+	long long llBits = clcoder.Prepare(&m_vecLens[0], n + 1);
+	if(clcoder.IsHuff())
+	{
+		vecHdr[0] |= HFM_FRAME_CL_HUFF;
+	}
+
+	int iHdrLen = (int)vecHdr.size();
+	int iOutLen = iHdrLen + (int)((llBits + 7) / 8);
+	unsigned char * pOut = new unsigned char[iOutLen];
+	memcpy(pOut, &vecHdr[0], iHdrLen);
+
+	CBitWriter writer(pOut + iHdrLen);
+	clcoder.Write(writer);
+	writer.Flush();
+
+	*ppOutput = (char *)pOut;
+	*pOutputLen = iOutLen;
+
+	return iOutLen;
+}
+
+template<typename _EL>
+bool CHuffmanCodebook<_EL>::Load(const char * pData, int iDataLen)
+{
+	const unsigned char * p = (const unsigned char *)pData;
+	const unsigned char * end = p + iDataLen;
+	unsigned long long n = 0;
+
+	Clear();
+
+	if(iDataLen < 2)
+	{
+		return false;
+	}
+
+	unsigned char type = *p++;
+	if((type & HFM_FRAME_TYPE_MASK) != HFM_FRAME_BOOK || !HfmGetVarint(p, end, n) || n > (1 << 24)
+		|| (sizeof(_EL) <= 2 && n > FLAT_SIZE))
+	{
+		return false;
+	}
+
+	if(n > 0 && !HfmReadElems(p, end, type, (int)n, m_vecElems))
+	{
+		return false;
+	}
+
+	// 元素表须严格升序, 否则索引表会重复
+	for(size_t i=1; i<m_vecElems.size(); i++)
+	{
+		if(!(m_vecElems[i-1] < m_vecElems[i]))
+		{
+			return false;
+		}
+	}
+
+	m_vecLens.resize((size_t)n + 1);
+	CBitReader reader(p, (int)(end - p));
+	if(!CCodeLenCoder::Read(reader, (type & HFM_FRAME_CL_HUFF) != 0, &m_vecLens[0], (int)n + 1))
+	{
+		return false;
+	}
+
+	return Setup();
+}
+
+template<typename _EL>
+long long CHuffmanCodebook<_EL>::GetBits(const _EL * pText, int iTextLen) const
+{
+	long long llBits = 0;
+
+	for(int i=0; i<iTextLen; i++)
+	{
+		int idx = Find(pText[i]);
+		llBits += m_vecLens[idx] + ((idx == m_iEsc) ? RAW_BITS : 0);
+	}
+
+	return llBits;
+}
+
+template<typename _EL>
+void CHuffmanCodebook<_EL>::Write(CBitWriter & writer, const _EL * pText, int iTextLen) const
+{
+	for(int i=0; i<iTextLen; i++)
+	{
+		int idx = Find(pText[i]);
+		writer.PutCode(m_vecCodes[idx], m_vecLens[idx]);
+		if(idx == m_iEsc)
+		{
+			writer.PutCode((unsigned long long)(_UT)pText[i], RAW_BITS);
+		}
+	}
+}
+
+template<typename _EL>
+template<typename _OT>
+bool CHuffmanCodebook<_EL>::Read(CBitReader & reader, int count, _OT * pOut) const
+{
+	for(int i=0; i<count; i++)
+	{
+		reader.Refill();
+		int idx = m_decTable.DecodeOne(reader);
+		if(idx < 0)
+		{
+			return false;
+		}
+
+		if(idx < m_iEsc)
+		{
+			pOut[i] = (_OT)m_vecElems[idx];
+			continue;
+		}
+
+		pOut[i] = (_OT)HfmReadRaw<_EL>(reader);
+	}
+
+	return true;
+}
+
+/*编码表: 由元素值直接取整数码字和码长, 每个元素编码只需一次查表和一次移位或
+  单字节/双字节元素用按元素值索引的平坦数组, 其他元素用哈希表*/
+template<typename _EL>
+class CHfmEncTable
+{
+public:
+	struct _Entry
+	{
+		unsigned long long	code;		// 码字, 右对齐
+		int					len;		// 码长, 0为不在表中
+		int					idx;		// 元素索引
+	};
+
+	CHfmEncTable():m_lo(0), m_iSize(0)
+	{
+		m_none.code = 0;
+		m_none.len = 0;
+		m_none.idx = -1;
+		m_esc = m_none;
+	}
+
+	void Clear();
+	bool IsEmpty() const { return m_iSize == 0; }
+	// size个元素及其码长、码字; bCompact: 平坦数组只覆盖元素值范围, 用于码表缓存等长期保存的表
+	void Build(const _EL * pElems, const int * pLens, const unsigned long long * pCodes, int size, bool bCompact = false);
+	// 转义码, 表中没有的元素写为转义码 + 元素原值; 在Build之后设置
+	void SetEscape(unsigned long long code, int len){ m_esc.code = code; m_esc.len = len; m_esc.idx = m_iSize; }
+
+	inline const _Entry & Find(_EL e) const
+	{
+		if(sizeof(_EL) <= 2)
+		{
+			// 整表时m_lo为0, 总在范围内
+			unsigned int off = (unsigned int)((_UT)e - m_lo);
+			return (off < m_vecFlat.size()) ? m_vecFlat[off] : m_none;
+		}
+		typename unordered_map<_EL, int>::const_iterator iter = m_mapIdx.find(e);
+		return (iter == m_mapIdx.end()) ? m_none : m_vecEntries[iter->second];
+	}
+
+	inline void Put(CBitWriter & writer, _EL e) const
+	{
+		const _Entry & ent = Find(e);
+		if(ent.len > 0)
+		{
+			writer.PutCode(ent.code, ent.len);
+			return;
+		}
+		writer.PutCode(m_esc.code, m_esc.len);
+		writer.PutCode((unsigned long long)(_UT)e, RAW_BITS);
+	}
+
+private:
+	typedef typename make_unsigned<_EL>::type _UT;
+	enum { RAW_BITS = 8 * sizeof(_EL), FLAT_SIZE = 1 << (sizeof(_EL) <= 2 ? RAW_BITS : 0) };
+
+	vector<_Entry>				m_vecFlat;		// 单字节/双字节元素: 元素值 - m_lo到表项
+	_UT							m_lo;			// 平坦数组首项的元素值, 整表时为0
+	vector<_Entry>				m_vecEntries;	// 其他元素: 按元素索引的表项
+	unordered_map<_EL, int>		m_mapIdx;		// 其他元素: 元素值到索引
+	vector<_EL>					m_vecKeys;		// 已填入平坦表的元素, 清除时只复位这些项
+	_Entry						m_none;
+	_Entry						m_esc;			// 转义码, 码长0为不转义
+	int							m_iSize;
+};
+
+template<typename _EL>
+void CHfmEncTable<_EL>::Clear()
+{
+	// 双字节元素的平坦表较大, 整表时保留数组只复位用过的项
+	if(m_lo == 0 && m_vecFlat.size() == FLAT_SIZE)
+	{
+		for(size_t i=0; i<m_vecKeys.size(); i++)
+		{
+			m_vecFlat[(_UT)m_vecKeys[i]] = m_none;
+		}
+	}
+	else
+	{
+		m_vecFlat.clear();
+		m_lo = 0;
+	}
+	m_vecKeys.clear();
+	m_vecEntries.clear();
+	m_mapIdx.clear();
+	m_esc = m_none;
+	m_iSize = 0;
+}
+
+template<typename _EL>
+void CHfmEncTable<_EL>::Build(const _EL * pElems, const int * pLens, const unsigned long long * pCodes, int size, bool bCompact)
+{
+	Clear();
+
+	if(sizeof(_EL) <= 2)
+	{
+		if(bCompact)
+		{
+			// 只分配元素值范围内的项, 缓存许多码表时双字节元素也不必每表65536项
+			_UT lo = (size > 0) ? (_UT)pElems[0] : 0;
+			_UT hi = lo;
+			for(int i=1; i<size; i++)
+			{
+				lo = min(lo, (_UT)pElems[i]);
+				hi = max(hi, (_UT)pElems[i]);
+			}
+			m_lo = lo;
+			m_vecFlat.assign((size > 0) ? (size_t)(hi - lo) + 1 : 0, m_none);
+		}
+		else if(m_vecFlat.empty())
+		{
+			m_vecFlat.assign(FLAT_SIZE, m_none);
+		}
+		m_vecKeys.assign(pElems, pElems + size);
+		for(int i=0; i<size; i++)
+		{
+			_Entry & ent = m_vecFlat[(_UT)((_UT)pElems[i] - m_lo)];
+			ent.code = pCodes[i];
+			ent.len = pLens[i];
+			ent.idx = i;
+		}
+	}
+	else
+	{
+		m_vecEntries.resize(size);
+		m_mapIdx.reserve(size);
+		for(int i=0; i<size; i++)
+		{
+			m_vecEntries[i].code = pCodes[i];
+			m_vecEntries[i].len = pLens[i];
+			m_vecEntries[i].idx = i;
+			m_mapIdx[pElems[i]] = i;
+		}
+	}
+
+	m_iSize = size;
+}
+
+/*码表缓存: 由统计结果(元素表+可选量化后的权值+限长参数)的指纹查找已建好的码表
+  相同分布反复出现时免去建树、范式编码和建编码表/解码表; 按指纹分片, 查找只加读锁, 命中只置访问标记
+  每片容量固定, 满时按CLOCK淘汰; 指纹相同时再比较完整键值, 不会误用其他分布的码表
+  解码端另按帧头中元素表+码长的指纹查找, 与编码端共用同一批码表, 命中时不再建解码表*/
+#define HFM_CACHE_SHARDS	16		// 缓存分片数
+
+// 缓存的码表, 建好后只读, 由缓存和正在使用它的编解码器共同持有
+template<typename _EL>
+struct CHfmCodeSet
+{
+	vector<_EL>					elems;		// 键: 元素表, 转义时不含末项
+	vector<long long>			weights;	// 编码端键: 量化后的权值, 解码端建的码表为空
+	int							limit;		// 编码端键: 码长限制
+	int							mode;		// 编码端键: 限长方式
+	int							esc;		// 转义码索引, -1为不转义
+	vector<int>					lens;		// 码长, 解码端键
+	vector<unsigned long long>	codes;		// 范式码字, 右对齐
+	CHfmEncTable<_EL>			enc;		// 编码表, 解码端建的码表为空
+	CHuffmanDecTable			dec;		// 解码表
+};
+
+template<typename _EL>
+class CHfmCodeCache
+{
+public:
+	typedef shared_ptr<const CHfmCodeSet<_EL>> _SetPtr;
+
+	// iCapacity: 编码端、解码端各自最多缓存的码表数; iQuantBits: 权值保留的有效位数, 0 - 不量化
+	// 量化后相近的分布共用码表, 码长按量化权值计算, 略有损失
+	CHfmCodeCache(int iCapacity = 256, int iQuantBits = 0)
+		:m_iQuantBits(iQuantBits), m_llHits(0), m_llMisses(0)
+	{
+		m_iSlots = max(1, (iCapacity + HFM_CACHE_SHARDS - 1) / HFM_CACHE_SHARDS);
+		for(int k=0; k<HFM_CACHE_SHARDS; k++)
+		{
+			m_shards[k].slots.reset(new _Slot[m_iSlots]);
+			m_shards[k].hand = 0;
+			m_decShards[k].slots.reset(new _Slot[m_iSlots]);
+			m_decShards[k].hand = 0;
+		}
+	}
+
+	// 编码端: 取pElems/pWeights对应的码表, 未缓存时建表并加入; 限长失败返回空
+	// iEsc: 转义码索引(pElems中该项不使用), -1为不转义; vecKey: 调用方保留容量的缓冲, 存放量化后的权值
+	template<typename W>
+	_SetPtr Get(const _EL * pElems, const W * pWeights, int n, int iEsc, int iLimit, int iMode, vector<long long> & vecKey);
+	// 解码端: 取帧头中n个元素、size个码长(转义时末项为转义码)对应的码表, 未缓存时建解码表并加入
+	// 解码表一级表位数为iTableBits; 码长不合法返回空
+	_SetPtr Find(const _EL * pElems, int n, const int * pLens, int size, int iTableBits);
+
+	long long GetHits(){ return m_llHits; }
+	long long GetMisses(){ return m_llMisses; }
+	void Clear();
+
+private:
+	struct _Slot
+	{
+		_Slot():fp(0), ref(false){}
+
+		_SetPtr				set;
+		unsigned long long	fp;
+		atomic<bool>		ref;			// CLOCK访问标记
+	};
+
+	struct _Shard
+	{
+		shared_timed_mutex						mtx;
+		unordered_map<unsigned long long, int>	index;	// 指纹到槽位
+		unique_ptr<_Slot[]>						slots;
+		int										hand;	// CLOCK指针
+	};
+
+	// 在一组分片中按指纹查找, 完整键值满足pred时命中并置访问标记
+	template<typename _Pred>
+	_SetPtr Lookup(_Shard * pShards, unsigned long long fp, _Pred pred);
+	// 加入一组分片: 同指纹的槽位直接替换, 否则按CLOCK找未被访问的槽位
+	void Insert(_Shard * pShards, unsigned long long fp, const _SetPtr & set);
+
+	// 解码端指纹
+	static unsigned long long LensPrint(const _EL * pElems, int n, const int * pLens, int size, int iTableBits)
+	{
+		unsigned long long fp = Mix(Mix((unsigned long long)n, (unsigned long long)size), (unsigned long long)iTableBits);
+		for(int i=0; i<n; i++)
+		{
+			fp = Mix(fp, (unsigned long long)(long long)pElems[i]);
+		}
+		for(int i=0; i<size; i++)
+		{
+			fp = Mix(fp, (unsigned long long)pLens[i]);
+		}
+		return fp;
+	}
+
+	static unsigned long long Mix(unsigned long long h, unsigned long long v)
+	{
+		h ^= v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+		return h * 0xFF51AFD7ED558CCDull;
+	}
+
+private:
+	int					m_iQuantBits;
+	int					m_iSlots;				// 每片槽位数
+	_Shard				m_shards[HFM_CACHE_SHARDS];		// 编码端索引
+	_Shard				m_decShards[HFM_CACHE_SHARDS];	// 解码端索引
+	atomic<long long>	m_llHits;
+	atomic<long long>	m_llMisses;
+};
+
+template<typename _EL>
+template<typename W>
+typename CHfmCodeCache<_EL>::_SetPtr CHfmCodeCache<_EL>::Get(const _EL * pElems, const W * pWeights, int n, int iEsc, int iLimit, int iMode, vector<long long> & vecKey)
+{
+	int m = (iEsc >= 0) ? iEsc : n;
+	unsigned long long fp = Mix(Mix(Mix((unsigned long long)n, (unsigned long long)iLimit), (unsigned long long)iMode), (unsigned long long)(long long)iEsc);
+
+	vecKey.resize(n);
+	for(int i=0; i<n; i++)
+	{
+		long long w = (long long)pWeights[i];
+
+		// 量化: 只保留最高m_iQuantBits个有效位
+		if(m_iQuantBits > 0)
+		{
+			int bits = 0;
+			while(bits < 63 && (w >> bits) > 0)
+			{
+				bits++;
+			}
+			int sh = max(0, bits - m_iQuantBits);
+			w = (w >> sh) << sh;
+		}
+
+		vecKey[i] = w;
+		fp = Mix(fp, (unsigned long long)w);
+		if(i < m)
+		{
+			fp = Mix(fp, (unsigned long long)(long long)pElems[i]);
+		}
+	}
+
+	_SetPtr hit = Lookup(m_shards, fp, [&](const CHfmCodeSet<_EL> & set){
+		return set.limit == iLimit && set.mode == iMode && set.esc == iEsc && set.weights == vecKey
+			&& set.elems.size() == (size_t)m && equal(set.elems.begin(), set.elems.end(), pElems);
+	});
+	if(hit)
+	{
+		m_llHits++;
+		return hit;
+	}
+
+	m_llMisses++;
+
+	// 建表不持锁, 与CanonicCreat()计算的码长相同
+	shared_ptr<CHfmCodeSet<_EL>> set = make_shared<CHfmCodeSet<_EL>>();
+	set->elems.assign(pElems, pElems + m);
+	set->weights = vecKey;
+	set->limit = iLimit;
+	set->mode = iMode;
+	set->esc = iEsc;
+
+	CHuffman<long long> huff;
+	huff.CreatCodeLens(&set->weights[0], n);
+	set->lens = huff.GetCodeLens();
+	if(iLimit > 0 && !HfmLimitCodeLens(&set->weights[0], n, iLimit, iMode, &set->lens[0]))
+	{
+		return _SetPtr();
+	}
+	set->codes.resize(n);
+	HfmCanonicCodes(&set->lens[0], n, &set->codes[0]);
+
+	set->enc.Build(pElems, &set->lens[0], &set->codes[0], m, true);
+	if(iEsc >= 0)
+	{
+		set->enc.SetEscape(set->codes[iEsc], set->lens[iEsc]);
+	}
+	if(!set->dec.Build(&set->lens[0], n))
+	{
+		return _SetPtr();
+	}
+
+	Insert(m_shards, fp, set);
+	Insert(m_decShards, LensPrint(pElems, m, &set->lens[0], n, set->dec.GetTableBits()), set);
+	return set;
+}
+
+template<typename _EL>
+typename CHfmCodeCache<_EL>::_SetPtr CHfmCodeCache<_EL>::Find(const _EL * pElems, int n, const int * pLens, int size, int iTableBits)
+{
+	unsigned long long fp = LensPrint(pElems, n, pLens, size, iTableBits);
+
+	_SetPtr hit = Lookup(m_decShards, fp, [&](const CHfmCodeSet<_EL> & set){
+		return set.dec.GetTableBits() == iTableBits && set.elems.size() == (size_t)n && set.lens.size() == (size_t)size
+			&& equal(set.elems.begin(), set.elems.end(), pElems) && equal(set.lens.begin(), set.lens.end(), pLens);
+	});
+	if(hit)
+	{
+		m_llHits++;
+		return hit;
+	}
+
+	m_llMisses++;
+
+	// 只有码长时只建解码表, 这样的码表不进入编码端索引
+	shared_ptr<CHfmCodeSet<_EL>> set = make_shared<CHfmCodeSet<_EL>>();
+	set->elems.assign(pElems, pElems + n);
+	set->limit = 0;
+	set->mode = 0;
+	set->esc = (size > n) ? n : -1;
+	set->lens.assign(pLens, pLens + size);
+	set->dec.SetTableBits(iTableBits);
+	if(!set->dec.Build(pLens, size))
+	{
+		return _SetPtr();
+	}
+
+	Insert(m_decShards, fp, set);
+	return set;
+}
+
+template<typename _EL>
+template<typename _Pred>
+typename CHfmCodeCache<_EL>::_SetPtr CHfmCodeCache<_EL>::Lookup(_Shard * pShards, unsigned long long fp, _Pred pred)
+{
+	_Shard & shard = pShards[fp % HFM_CACHE_SHARDS];
+
+	shared_lock<shared_timed_mutex> lock(shard.mtx);
+	typename unordered_map<unsigned long long, int>::iterator iter = shard.index.find(fp);
+	if(iter != shard.index.end())
+	{
+		_Slot & slot = shard.slots[iter->second];
+		if(pred(*slot.set))
+		{
+			slot.ref.store(true, memory_order_relaxed);
+			return slot.set;
+		}
+	}
+	return _SetPtr();
+}
+
+template<typename _EL>
+void CHfmCodeCache<_EL>::Insert(_Shard * pShards, unsigned long long fp, const _SetPtr & set)
+{
+	_Shard & shard = pShards[fp % HFM_CACHE_SHARDS];
+
+	unique_lock<shared_timed_mutex> lock(shard.mtx);
+
+	int pos = -1;
+	typename unordered_map<unsigned long long, int>::iterator iter = shard.index.find(fp);
+	if(iter != shard.index.end())
+	{
+		pos = iter->second;
+	}
+	else
+	{
+		for(;;)
+		{
+			_Slot & slot = shard.slots[shard.hand];
+			int cur = shard.hand;
+			shard.hand = (shard.hand + 1) % m_iSlots;
+
+			if(!slot.set || !slot.ref.exchange(false, memory_order_relaxed))
+			{
+				pos = cur;
+				break;
+			}
+		}
+
+		if(shard.slots[pos].set)
+		{
+			shard.index.erase(shard.slots[pos].fp);
+		}
+		shard.index[fp] = pos;
+	}
+
+	_Slot & slot = shard.slots[pos];
+	slot.set = set;
+	slot.fp = fp;
+	slot.ref.store(false, memory_order_relaxed);
+}
+
+template<typename _EL>
+void CHfmCodeCache<_EL>::Clear()
+{
+	_Shard * groups[2] = {m_shards, m_decShards};
+	for(int g=0; g<2; g++)
+	{
+		for(int k=0; k<HFM_CACHE_SHARDS; k++)
+		{
+			_Shard & shard = groups[g][k];
+			unique_lock<shared_timed_mutex> lock(shard.mtx);
+			shard.index.clear();
+			for(int i=0; i<m_iSlots; i++)
+			{
+				shard.slots[i].set.reset();
+				shard.slots[i].ref.store(false, memory_order_relaxed);
+			}
+			shard.hand = 0;
+		}
+	}
+}
+
+template<typename _EL, typename _WT>
+class CHuffmanCodec: 
+	public CElemStat<_EL>, public CHuffman<_WT>
+{
+public:
+	typedef CElemStat<_EL> _ElemStat;
+	typedef CHuffman<_WT> _Huffman;
+
+	CHuffmanCodec():_ElemStat(), _Huffman()
+	{
+		m_pElems = nullptr;
+		m_pWeights = nullptr;
+		m_iElemNum = 0;
+		m_iTextLen = 0;
+		m_iFormat = HFM_FMT_BITCHAR;
+		m_iLimit = 0;
+		m_iLimitMode = HFM_LIMIT_PACKAGE_MERGE;
+		m_iStatThreads = 1;
+		m_iBlockSize = 0;
+		m_iBlockThreads = 0;
+		m_pPool = nullptr;
+		m_iStreams = 1;
+		m_iEscTopK = 0;
+		m_iEscIdx = -1;
+		m_llEscCount = 0;
+		m_pBook = nullptr;
+		m_pCache = nullptr;
+		m_pEnc = &m_encTable;
+		m_iStmState = 0;
+		m_llStmIn = 0;
+		m_llStmOut = 0;
+		m_iStmPos = 0;
+		m_pUserOut = nullptr;
+		m_iUserCap = 0;
+		m_bUserOut = false;
+	}
+	virtual ~CHuffmanCodec(){Reset(); TRACE("called destructor of class CHuffmanCodec!\r\n");}
+
+	int Encode(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen);
+	int Decode(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen);
+	// 结果直接写入调用方的缓冲, 不分配输出、不经中间缓冲复制; 返回输出长度, 缓冲不足或出错返回-1
+	// 容量按GetEncodeBound()/GetDecodedSize()分配即不会不足, 缓冲可在多次调用间复用
+	int EncodeTo(_EL * pText, int iTextLen, char * pOut, int iOutCap);
+	int DecodeTo(_EL * pText, int iTextLen, char * pOut, int iOutCap);
+	// 解码为元素类型: Decode/DecodeTo每个元素输出一个char, 多字节元素会被截断; pData为Encode的输出
+	// 输出由new[]分配, 或写入调用方容量为iOutCap个元素的缓冲; 返回元素个数, 出错返回-1
+	int DecodeElems(const char * pData, int iDataLen, _EL ** ppOutput, int * pOutputLen);
+	int DecodeElems(const char * pData, int iDataLen, _EL * pOut, int iOutCap);
+	// 按当前格式和设置编码iTextLen个元素的最大输出长度
+	long long GetEncodeBound(int iTextLen);
+	// 解码后的长度: 帧格式由帧头读出, 紧凑位流为本对象上次编码的元素个数; 其他格式或帧头错误返回-1
+	int GetDecodedSize(const char * pData, int iDataLen);
+
+	// iFormat: HFM_FMT_BITCHAR / HFM_FMT_PACKED / HFM_FMT_FRAME / HFM_FMT_ADAPTIVE
+	// 逐块送入数据、要求低延迟时直接用CHuffmanAdaptive的流式接口
+	void SetFormat(int iFormat){ m_iFormat = iFormat; }
+	int GetFormat(){ return m_iFormat; }
+	// 限定最长码长, iLimit: 0 - 不限长; 码长不超过一级表位数时解码只需一次查表
+	// iMode: HFM_LIMIT_PACKAGE_MERGE - 最优; HFM_LIMIT_KRAFT - 快速
+	void SetCodeLenLimit(int iLimit, int iMode = HFM_LIMIT_PACKAGE_MERGE){ m_iLimit = iLimit; m_iLimitMode = iMode; }
+	// 统计线程数, 1 - 单线程(默认), 0 - 线程池全部线程
+	void SetStatThreads(int iThreads){ m_iStatThreads = iThreads; }
+	// 分块编码(仅HFM_FMT_FRAME): 每iBlockSize个元素单独统计、建表、编码, 0 - 不分块
+	// iThreads: 1 - 单线程, 0 - 线程池并行编码各块; 解码分块帧时同样按此并行
+	void SetBlockSize(int iBlockSize, int iThreads = 0){ m_iBlockSize = iBlockSize; m_iBlockThreads = iThreads; }
+	// 多线程统计和分块编解码使用的线程池, 线程数由线程池决定; nullptr - CHfmThreadPool::Default()
+	// 线程池须在编解码期间有效
+	void SetThreadPool(CHfmThreadPool * pPool){ m_pPool = pPool; }
+	// 帧数据分为iStreams路交错子流(仅HFM_FMT_FRAME), 1 - 单路, 取不超过iStreams的2的幂, 最多HFM_MAX_STREAMS路
+	// 4路及以上、每路元素足够多且最长码长不超过一级表位数时用SIMD解码(AVX2用于8路、16路, 其余用SSE4.1)
+	void SetStreams(int iStreams)
+	{
+		m_iStreams = 1;
+		while(m_iStreams * 2 <= min(iStreams, HFM_MAX_STREAMS))
+		{
+			m_iStreams *= 2;
+		}
+	}
+	// 转义(HFM_FMT_PACKED / HFM_FMT_FRAME): 元素种类超过iTopK时只给出现最多的iTopK种建码, 其余写为转义码 + 元素原值
+	// 适合16位/32位元素的长尾分布, 码表和解码表大小与元素种类无关; 0 - 不转义
+	void SetEscape(int iTopK){ m_iEscTopK = max(iTopK, 0); }
+	// 预训练码书(仅HFM_FMT_FRAME): 编码跳过统计、建树和码表生成, 输出码书帧; 解码码书帧时使用
+	// 码书须在编解码期间有效, 解码须用编码时的同一码书; nullptr - 不用码书; 同时分块时各块为码书帧
+	void SetCodebook(const CHuffmanCodebook<_EL> * pBook){ m_pBook = pBook; }
+	// 码表缓存(HFM_FMT_PACKED / HFM_FMT_FRAME): 统计结果命中缓存时不再建树和编码表/解码表, 解码帧时帧头命中缓存不再建解码表
+	// 可由多个线程中的编解码器共用
+	void SetCodeCache(CHfmCodeCache<_EL> * pCache){ m_pCache = pCache; m_frm.pCache = pCache; }
+	// 紧凑位流查表解码的一级表位数
+	void SetTableBits(int iBits){ m_decTable.SetTableBits(iBits); m_decTable.Clear(); m_frm.table.SetTableBits(iBits); }
+
+	// 流式编解码, 数据经回调输出, 回调返回false时中止
+	typedef function<bool(const char * pData, size_t iLen)>	_ByteSink;
+	typedef function<bool(const _EL * pElems, size_t iLen)>	_ElemSink;
+
+	// 流式编码: 输入按块(SetBlockSize, 未设时HFM_STREAM_BLOCK)编码为帧, 每帧写出
+	bool EncodeBegin(const _ByteSink & sink);
+	bool EncodeFeed(const _EL * pText, size_t iTextLen);
+	bool EncodeFlush();						// 缓存的不足一块的输入立即编码为帧
+	bool EncodeFinish();					// 编码剩余输入并写结束标记
+	// 流式解码: 输入可在任意位置断开, 每解出一帧即输出
+	bool DecodeBegin(const _ElemSink & sink);
+	bool DecodeFeed(const char * pData, size_t iDataLen);
+	bool DecodeFinish();					// 结束标记之前的数据全部收到返回true
+	// 本次流已输入/输出的字节数或元素个数
+	unsigned long long GetStreamIn(){ return m_llStmIn; }
+	unsigned long long GetStreamOut(){ return m_llStmOut; }
+
+public:
+	// 清除上次编解码的状态, 保留已分配的缓冲; 同一对象可依次处理大量消息, 配合EncodeTo/DecodeTo时热路径不分配内存
+	void Reset();
+
+private:
+	// 有界输出, 供扁平解码树直接写入
+	template<typename _OT>
+	struct _OutSpan
+	{
+		_OT *	beg;
+		_OT *	p;
+		_OT *	end;
+		bool	over;				// 超出容量
+
+		void push_back(_OT c)
+		{
+			if(p < end)
+			{
+				*p++ = c;
+			}
+			else
+			{
+				over = true;
+			}
+		}
+	};
+
+	// 帧解码状态, 并行解码时每块一份
+	struct _FrameDec
+	{
+		_FrameDec():pCache(nullptr), pTable(nullptr){}
+
+		CHuffmanDecTable	table;			// 解码表
+		CHuffmanDecTable	cltable;		// 码长码的解码表
+		vector<_EL>			elems;			// 元素表
+		vector<int>			lens;			// 码长
+		CHfmCodeCache<_EL> *	pCache;		// 码表缓存, nullptr为不用
+		typename CHfmCodeCache<_EL>::_SetPtr	set;	// 取自缓存的码表
+		const CHuffmanDecTable *	pTable;	// 本帧使用的解码表: table或缓存码表的解码表
+	};
+
+	// 分块编解码的工作上下文, 每个同时执行的块任务占用一份, 跨消息保留
+	struct _BlockCtx
+	{
+		unique_ptr<CHuffmanCodec>	codec;		// 块编码器
+		_FrameDec					dec;		// 块解码状态
+	};
+
+	// 取一份空闲的上下文, 没有时新建; 同时占用的份数不超过并行执行的块数
+	_BlockCtx * AcquireBlockCtx()
+	{
+		lock_guard<mutex> lock(m_mtxBlk);
+		if(m_vecBlkFree.empty())
+		{
+			m_vecBlkCtx.push_back(unique_ptr<_BlockCtx>(new _BlockCtx));
+			m_vecBlkCtx.back()->codec.reset(new CHuffmanCodec());
+			m_vecBlkFree.push_back(m_vecBlkCtx.back().get());
+		}
+		_BlockCtx * ctx = m_vecBlkFree.back();
+		m_vecBlkFree.pop_back();
+		return ctx;
+	}
+	void ReleaseBlockCtx(_BlockCtx * ctx)
+	{
+		lock_guard<mutex> lock(m_mtxBlk);
+		m_vecBlkFree.push_back(ctx);
+	}
+
+	// 按当前格式解码, 输出为_OT类型; HFM_FMT_BITCHAR时pText每个_BT为一位
+	template<typename _BT, typename _OT>
+	int DecodeAs(const _BT * pText, int iTextLen, _OT ** ppOutput, int * pOutputLen);
+	void SelectEscape();
+	int EncodePacked(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen);
+	template<typename _OT>
+	int DecodePacked(const unsigned char * pData, int iDataLen, _OT ** ppOutput, int * pOutputLen);
+	int EncodeFrame(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen);
+	template<typename _OT>
+	int DecodeFrame(const unsigned char * pData, int iDataLen, _OT ** ppOutput, int * pOutputLen);
+	int EncodeFrameMulti(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen, vector<unsigned char> & vecHdr, CCodeLenCoder & clcoder, int N);
+	template<int N>
+	static void StreamBits(const CHfmEncTable<_EL> & table, const _EL * pText, int iTextLen, long long * pBits);
+	template<int N>
+	static void EncodeStreams(const CHfmEncTable<_EL> & table, const _EL * pText, int iTextLen, CBitWriter * pWriters);
+	int EncodeBlocks(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen);
+	template<typename _OT>
+	int DecodeBlocks(const unsigned char * pData, int iDataLen, _OT ** ppOutput, int * pOutputLen);
+	static bool ReadFrameHead(const unsigned char *& p, const unsigned char * end, unsigned char & type, int & count);
+	template<typename _OT>
+	static bool DecodeFrameData(const unsigned char * p, const unsigned char * end, unsigned char type, int count, _OT * pOut, _FrameDec & dec);
+	template<int N, typename _OT>
+	static bool DecodeStreams(CBitReader * pReaders, int count, _OT * pOut, _FrameDec & dec);
+	// 各路解一个元素; 按编译期下标展开, 读取器只以常量下标访问, 可拆为标量留在寄存器中
+	template<size_t... K>
+	static void DecodeRound(CBitReader * pReaders, const CHuffmanDecTable & table, int * pIdx, index_sequence<K...>)
+	{
+		int dummy[] = {(pReaders[K].Refill(), pIdx[K] = table.DecodeOne(pReaders[K]))...};
+		(void)dummy;
+	}
+	template<typename _OT>
+	static bool DecodeStreamsSimd(int N, const unsigned char * p, const unsigned char * end, const unsigned long long * pLens,
+		CBitReader * pReaders, int count, _OT * pOut, _FrameDec & dec);
+	bool StreamEncodeBlock();
+	bool StreamDecodeFrames();
+	long long MakeIntCodes();
+	// 本次编码的码长: 取自码表缓存时为缓存码表的码长
+	const vector<int> & CodeLens() const { return m_pSet ? m_pSet->lens : CHuffman<_WT>::m_vecCodeLens; }
+	long long GetFrameBound(int iTextLen);
+	// 输出缓冲: EncodeTo/DecodeTo/DecodeElems时为调用方缓冲(容量不足返回false), 否则new[]分配(多1项放结尾0)
+	template<typename _OT>
+	bool AllocOut(long long llLen, _OT *& pOut)
+	{
+		if(!m_bUserOut)
+		{
+			pOut = new _OT[(size_t)llLen + 1];
+			return true;
+		}
+		pOut = (_OT *)m_pUserOut;
+		return llLen <= m_iUserCap;
+	}
+	template<typename _OT>
+	void FreeOut(_OT * pOut)
+	{
+		if(!m_bUserOut)
+		{
+			delete[] pOut;
+		}
+	}
+	// 解码结果后补0, 调用方缓冲没有余量时不补
+	template<typename _OT>
+	void EndText(_OT * pOut, int iLen)
+	{
+		if(!m_bUserOut || iLen < m_iUserCap)
+		{
+			pOut[iLen] = (_OT)0;
+		}
+	}
+	// 0个元素的解码结果
+	template<typename _OT>
+	int EmptyOut(_OT ** ppOutput, int * pOutputLen)
+	{
+		_OT * pOut = nullptr;
+		if(!AllocOut(0, pOut))
+		{
+			return -1;
+		}
+		EndText(pOut, 0);
+
+		*ppOutput = pOut;
+		*pOutputLen = 0;
+
+		return 0;
+	}
+	int EncodeWithBook(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen);
+	int EncodeAdaptive(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen);
+	template<typename _OT>
+	int DecodeAdaptive(const char * pData, int iDataLen, _OT ** ppOutput, int * pOutputLen);
+	template<typename _OT>
+	static bool DecodeBookData(const unsigned char * p, const unsigned char * end, int count, _OT * pOut, const CHuffmanCodebook<_EL> * pBook);
+
+private:
+	_EL * m_pElems;							// 指向m_vecElemBuf
+	_WT * m_pWeights;						// 指向m_vecWeightBuf
+	vector<_EL>	m_vecElemBuf;				// 元素表缓冲, 复用时保留容量
+	vector<_WT>	m_vecWeightBuf;				// 权值缓冲
+	CCodeLenCoder			m_clcoder;		// 码长表编码器
+	vector<unsigned char>	m_vecHdr;		// 帧头缓冲
+	int	  m_iElemNum;
+	int	  m_iTextLen;						// 编码前元素个数, 紧凑位流解码时使用
+	int	  m_iFormat;						// 输出格式
+	int	  m_iLimit;							// 码长限制, 0为不限
+	int	  m_iLimitMode;						// 限长方式
+	int	  m_iStatThreads;					// 统计线程数
+	int	  m_iBlockSize;						// 分块编码的块大小, 0为不分块
+	int	  m_iBlockThreads;					// 分块编码线程数
+	CHfmThreadPool *	m_pPool;				// 线程池, nullptr为默认线程池
+	int	  m_iStreams;						// 帧数据子流路数
+	int	  m_iEscTopK;						// 转义时建码的元素种类数, 0为不转义
+	int	  m_iEscIdx;						// 转义码在码表中的索引, -1为本次不转义
+	long long	m_llEscCount;				// 转义的元素个数
+	vector<int>	m_vecEscIdx;				// 选取建码元素用, 保留容量
+	const CHuffmanCodebook<_EL> *	m_pBook;	// 预训练码书
+	CHfmCodeCache<_EL> *			m_pCache;	// 码表缓存
+	typename CHfmCodeCache<_EL>::_SetPtr	m_pSet;	// 本次编码取自缓存的码表, 紧凑位流解码时仍使用
+	vector<long long>	m_vecCacheKey;		// 查码表缓存用的量化权值, 保留容量
+	CHfmEncTable<_EL>	m_encTable;			// 元素值到码字的编码表
+	const CHfmEncTable<_EL> *	m_pEnc;		// 本次编码使用的编码表: m_encTable或缓存码表的编码表
+	CHuffmanDecTable	m_decTable;			// 查表解码器
+	_FrameDec			m_frm;				// 帧解码状态
+	int					m_iStmState;		// 流状态: 0 - 未开始, 1 - 进行中, 2 - 已结束, -1 - 出错
+	unsigned long long	m_llStmIn;			// 流已输入的元素个数/字节数
+	unsigned long long	m_llStmOut;			// 流已输出的字节数/元素个数
+	_ByteSink			m_stmByteSink;		// 流式编码输出
+	_ElemSink			m_stmElemSink;		// 流式解码输出
+	vector<_EL>			m_vecStmElems;		// 流式编码缓存的输入 / 流式解码的一帧输出
+	vector<unsigned char>	m_vecStmBytes;	// 流式解码缓存的输入
+	size_t				m_iStmPos;			// m_vecStmBytes中已处理的字节数
+	vector<char>		m_vecStmFrame;		// 流式编码的帧缓冲
+	unique_ptr<CHuffmanCodec>	m_pStmCodec;	// 流式编码的帧编码器
+	vector<unique_ptr<_BlockCtx>>	m_vecBlkCtx;	// 分块编解码的工作上下文
+	vector<_BlockCtx *>	m_vecBlkFree;		// 空闲的工作上下文
+	mutex				m_mtxBlk;
+	vector<vector<char>>	m_vecBlkOut;	// 分块编码各块的帧缓冲
+	vector<int>			m_vecBlkLen;		// 分块编码各块的帧长度
+	vector<long long>	m_vecBlkFrmPos;		// 分块解码各块的帧位置
+	vector<int>			m_vecBlkOutPos;		// 分块解码各块的输出位置
+	void *				m_pUserOut;			// 调用方提供的输出缓冲
+	int					m_iUserCap;			// 调用方缓冲的容量, 以输出类型计
+	bool				m_bUserOut;			// 是否输出到调用方缓冲
+};
+
+
+template<typename _EL, typename _WT>
+void CHuffmanCodec<_EL, _WT>::Reset()
+{
+	// 只清除状态, 各缓冲保留容量供下一条消息使用
+	m_pElems = nullptr;
+	m_pWeights = nullptr;
+	m_iElemNum = 0;
+	m_pSet.reset();
+	m_encTable.Clear();
+	m_pEnc = &m_encTable;
+	m_decTable.Clear();
+	m_iTextLen = 0;
+	m_iEscIdx = -1;
+	m_llEscCount = 0;
+
+	_ElemStat::Clear();
+	_Huffman::Reset();
+	_Huffman::ClearCodePtr();
+}
+
+template<typename _EL, typename _WT>
+int CHuffmanCodec<_EL, _WT>::Encode(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen)
+{
+	Reset();
+
+	if(m_iFormat == HFM_FMT_ADAPTIVE)
+	{
+		return EncodeAdaptive(pText, iTextLen, ppOutput, pOutputLen);
+	}
+
+	if(iTextLen <= 0)
+	{
+		if(m_iFormat == HFM_FMT_FRAME)
+		{
+			return EncodeFrame(pText, 0, ppOutput, pOutputLen);
+		}
+		if(!AllocOut(0, *ppOutput))
+		{
+			return -1;
+		}
+		*pOutputLen = 0;
+		return 0;
+	}
+
+	// 分块时各块再按码书或独立码表编码
+	if(m_iFormat == HFM_FMT_FRAME && m_iBlockSize > 0 && iTextLen > m_iBlockSize)
+	{
+		return EncodeBlocks(pText, iTextLen, ppOutput, pOutputLen);
+	}
+
+	if(m_iFormat == HFM_FMT_FRAME && m_pBook != nullptr)
+	{
+		return EncodeWithBook(pText, iTextLen, ppOutput, pOutputLen);
+	}
+
+	int elemnum = (m_iStatThreads == 1) ? this->Stat(pText, iTextLen) : this->StatParallel(pText, iTextLen, m_iStatThreads, m_pPool);
+
+	m_vecElemBuf.resize(max(elemnum, 1));
+	m_vecWeightBuf.resize(max(elemnum, 1));
+	m_pElems = &m_vecElemBuf[0];
+	m_pWeights = &m_vecWeightBuf[0];
+	m_iElemNum = this->GetStat(m_pElems, m_pWeights, elemnum);
+
+	TRACE("Elem: ");
+	for(int i=0; i<elemnum; i++)
+	{
+		TRACE("%c, ", m_pElems[i]);
+	}
+	TRACE("\r\n");
+
+	TRACE("Len: ");
+	for(int i=0; i<elemnum; i++)
+	{
+		TRACE("%d, ", m_pWeights[i]);
+	}
+	TRACE("\r\n");
+
+	TRACE("idx: ");
+	for(int i=0; i<elemnum; i++)
+	{
+		TRACE("%d, ", i);
+	}
+	TRACE("\r\n");
+
+	if(m_iEscTopK > 0 && m_iElemNum > m_iEscTopK && (m_iFormat == HFM_FMT_PACKED || m_iFormat == HFM_FMT_FRAME))
+	{
+		SelectEscape();
+	}
+
+	// 命中缓存时直接用缓存的码表(含编码表和解码表), 紧凑位流和帧格式不需要树和字符形式的码字
+	if(m_pCache != nullptr && m_iFormat != HFM_FMT_BITCHAR)
+	{
+		m_pSet = m_pCache->Get(m_pElems, m_pWeights, m_iElemNum, m_iEscIdx, m_iLimit, m_iLimitMode, m_vecCacheKey);
+		if(!m_pSet)
+		{
+			return -1;
+		}
+
+		m_iTextLen = iTextLen;
+		if(m_iFormat == HFM_FMT_PACKED)
+		{
+			return EncodePacked(pText, iTextLen, ppOutput, pOutputLen);
+		}
+		return EncodeFrame(pText, iTextLen, ppOutput, pOutputLen);
+	}
+
+	// 紧凑位流和帧格式只需码长和整数码字, 每位一个字符时才建树
+	bool bok = (m_iFormat == HFM_FMT_BITCHAR) ? this->CanonicCreat(m_pWeights, m_iElemNum, m_iLimit, m_iLimitMode)
+		: this->CanonicCodes(m_pWeights, m_iElemNum, m_iLimit, m_iLimitMode);
+	if(!bok)
+	{
+		return -1;
+	}
+
+	m_iTextLen = iTextLen;
+
+	if(m_iFormat == HFM_FMT_PACKED)
+	{
+		return EncodePacked(pText, iTextLen, ppOutput, pOutputLen);
+	}
+	if(m_iFormat == HFM_FMT_FRAME)
+	{
+		return EncodeFrame(pText, iTextLen, ppOutput, pOutputLen);
+	}
+	
+	// 每位一个字符: 由整数码字逐位展开, 总位数预先算出
+	long long llBits = MakeIntCodes();
+	char * pEnText = nullptr;
+	if(llBits > 0x7FFFFFFF || !AllocOut(llBits, pEnText))
+	{
+		return -1;
+	}
+
+	int iEnTextLen = (int)llBits;
+	char * pDst = pEnText;
+
+	for(int i=0; i<iTextLen; i++)
+	{
+		const typename CHfmEncTable<_EL>::_Entry & ent = m_pEnc->Find(pText[i]);
+		for(int j=ent.len-1; j>=0; j--)
+		{
+			*pDst++ = (char)((ent.code >> j) & 1);
+		}
+	}
+
+	*ppOutput = pEnText;
+	*pOutputLen = iEnTextLen;
+	
+	return iEnTextLen;
+}
+
+// 码字转为整数并建编码表, 返回编码后的数据位数(由权值和码长精确算出)
+template<typename _EL, typename _WT>
+long long CHuffmanCodec<_EL, _WT>::MakeIntCodes()
+{
+	const vector<int> & vecLens = CodeLens();
+	long long llBits = 0;
+
+	// 取自码表缓存时编码表已建好, 否则用CanonicCodes()算出的码字建表
+	if(m_pSet)
+	{
+		m_pEnc = &m_pSet->enc;
+	}
+	else
+	{
+		const vector<unsigned long long> & vecCodes = CHuffman<_WT>::GetIntCodes();
+		if(m_iEscIdx < 0)
+		{
+			m_encTable.Build(m_pElems, &vecLens[0], &vecCodes[0], m_iElemNum);
+		}
+		else
+		{
+			m_encTable.Build(m_pElems, &vecLens[0], &vecCodes[0], m_iEscIdx);
+			m_encTable.SetEscape(vecCodes[m_iEscIdx], vecLens[m_iEscIdx]);
+		}
+		m_pEnc = &m_encTable;
+	}
+
+	if(m_iEscIdx >= 0)
+	{
+		llBits += m_llEscCount * 8 * (long long)sizeof(_EL);
+	}
+
+	for(int i=0; i<m_iElemNum; i++)
+	{
+		llBits += (long long)m_pWeights[i] * vecLens[i];
+	}
+
+	return llBits;
+}
+
+/*选取建码元素: 按出现次数保留前m_iEscTopK种(相同时取元素值小的), 仍按元素值升序
+  其余元素合并为末项转义码, 权值为其出现次数之和; 末项的元素值不使用*/
+template<typename _EL, typename _WT>
+void CHuffmanCodec<_EL, _WT>::SelectEscape()
+{
+	int K = m_iEscTopK;
+	const _WT * w = m_pWeights;
+	vector<int> & vecIdx = m_vecEscIdx;
+
+	vecIdx.resize(m_iElemNum);
+	for(int i=0; i<m_iElemNum; i++)
+	{
+		vecIdx[i] = i;
+	}
+	nth_element(vecIdx.begin(), vecIdx.begin() + K, vecIdx.end(), [w](int a, int b){return w[b] < w[a] || (!(w[a] < w[b]) && a < b);});
+	sort(vecIdx.begin(), vecIdx.begin() + K);
+
+	long long llEsc = 0;
+	for(int i=K; i<m_iElemNum; i++)
+	{
+		llEsc += (long long)w[vecIdx[i]];
+	}
+
+	// 索引升序且vecIdx[i] >= i, 可原地前移
+	for(int i=0; i<K; i++)
+	{
+		m_pElems[i] = m_pElems[vecIdx[i]];
+		m_pWeights[i] = m_pWeights[vecIdx[i]];
+	}
+	m_pWeights[K] = (_WT)llEsc;
+
+	m_iElemNum = K + 1;
+	m_iEscIdx = K;
+	m_llEscCount = llEsc;
+}
+
+// 紧凑位流编码: 每个元素整码字写入64位累加器
+template<typename _EL, typename _WT>
+int CHuffmanCodec<_EL, _WT>::EncodePacked(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen)
+{
+	long long llBits = MakeIntCodes();
+
+	char * pOut = nullptr;
+	if((llBits + 7) / 8 > 0x7FFFFFFF || !AllocOut((llBits + 7) / 8, pOut))
+	{
+		return -1;
+	}
+
+	int iEnTextLen = (int)((llBits + 7) / 8);
+	unsigned char * pEnText = (unsigned char *)pOut;
+	CBitWriter writer(pEnText);
+
+	for(int i=0; i<iTextLen; i++)
+	{
+		m_pEnc->Put(writer, pText[i]);
+	}
+
+	writer.Flush();
+
+	*ppOutput = (char *)pEnText;
+	*pOutputLen = iEnTextLen;
+
+	return iEnTextLen;
+}
+
+// 紧凑位流解码, 依赖本对象Encode时建立的码表, 由码长建解码表查表解码
+template<typename _EL, typename _WT>
+template<typename _OT>
+int CHuffmanCodec<_EL, _WT>::DecodePacked(const unsigned char * pData, int iDataLen, _OT ** ppOutput, int * pOutputLen)
+{
+	// 编码0个元素时没有码表
+	if(m_iTextLen == 0)
+	{
+		return EmptyOut(ppOutput, pOutputLen);
+	}
+
+	// 码表取自缓存时直接用缓存的解码表
+	const CHuffmanDecTable * pTable = &m_decTable;
+	if(m_pSet && m_pSet->dec.GetTableBits() == m_decTable.GetTableBits())
+	{
+		pTable = &m_pSet->dec;
+	}
+	else if(m_decTable.IsEmpty())
+	{
+		const vector<int> & vecLens = CodeLens();
+		if(vecLens.empty() || !m_decTable.Build(&vecLens[0], (int)vecLens.size()))
+		{
+			return -1;
+		}
+	}
+
+	_OT * pDeText = nullptr;
+	if(!AllocOut(m_iTextLen, pDeText))
+	{
+		return -1;
+	}
+	CBitReader reader(pData, iDataLen);
+
+	for(int i=0; i<m_iTextLen; i++)
+	{
+		reader.Refill();
+		int idx = pTable->DecodeOne(reader);
+		if(idx < 0)
+		{
+			FreeOut(pDeText);
+			return -1;
+		}
+
+		pDeText[i] = (idx == m_iEscIdx) ? (_OT)HfmReadRaw<_EL>(reader) : (_OT)m_pElems[idx];
+	}
+
+	EndText(pDeText, m_iTextLen);
+
+	*ppOutput = pDeText;
+	*pOutputLen = m_iTextLen;
+
+	return m_iTextLen;
+}
+
+// 自描述帧编码
+template<typename _EL, typename _WT>
+int CHuffmanCodec<_EL, _WT>::EncodeFrame(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen)
+{
+	vector<unsigned char> & vecHdr = m_vecHdr;
+	vecHdr.clear();
+	vecHdr.push_back(HFM_FRAME_HUFFMAN);
+	HfmPutVarint(vecHdr, (unsigned long long)iTextLen);
+
+	if(iTextLen <= 0)
+	{
+		char * pEnText = nullptr;
+		if(!AllocOut((long long)vecHdr.size(), pEnText))
+		{
+			return -1;
+		}
+		memcpy(pEnText, &vecHdr[0], vecHdr.size());
+		*ppOutput = pEnText;
+		*pOutputLen = (int)vecHdr.size();
+		return *pOutputLen;
+	}
+
+	// 转义时元素表不含末项转义码
+	int n = (m_iEscIdx < 0) ? m_iElemNum : m_iEscIdx;
+	HfmPutVarint(vecHdr, (unsigned long long)n);
+	HfmWriteElems(m_pElems, n, vecHdr);
+	if(m_iEscIdx >= 0)
+	{
+		vecHdr[0] |= HFM_FRAME_ESCAPE;
+	}
+
+	long long llBits = MakeIntCodes();
+
+	const vector<int> & vecLens = CodeLens();
+	CCodeLenCoder & clcoder = m_clcoder;
+	llBits += clcoder.Prepare(&vecLens[0], m_iElemNum);
+	if(clcoder.IsHuff())
+	{
+		vecHdr[0] |= HFM_FRAME_CL_HUFF;
+	}
+
+	int N = m_iStreams;
+	if(N > 1 && iTextLen >= N && m_iEscIdx < 0)
+	{
+		return EncodeFrameMulti(pText, iTextLen, ppOutput, pOutputLen, vecHdr, clcoder, N);
+	}
+
+	int iHdrLen = (int)vecHdr.size();
+	char * pOut = nullptr;
+	if(iHdrLen + (llBits + 7) / 8 > 0x7FFFFFFF || !AllocOut(iHdrLen + (llBits + 7) / 8, pOut))
+	{
+		return -1;
+	}
+
+	int iEnTextLen = iHdrLen + (int)((llBits + 7) / 8);
+	unsigned char * pEnText = (unsigned char *)pOut;
+	memcpy(pEnText, &vecHdr[0], iHdrLen);
+
+	CBitWriter writer(pEnText + iHdrLen);
+	clcoder.Write(writer);
+
+	for(int i=0; i<iTextLen; i++)
+	{
+		m_pEnc->Put(writer, pText[i]);
+	}
+
+	writer.Flush();
+
+	*ppOutput = (char *)pEnText;
+	*pOutputLen = iEnTextLen;
+
+	return iEnTextLen;
+}
+
+// 多路子流帧编码: 先算出各路位数写入跳转表, 再各路交错写位流
+template<typename _EL, typename _WT>
+int CHuffmanCodec<_EL, _WT>::EncodeFrameMulti(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen, vector<unsigned char> & vecHdr, CCodeLenCoder & clcoder, int N)
+{
+	long long llBits[HFM_MAX_STREAMS] = {0};
+
+	switch(N)
+	{
+	case 2: StreamBits<2>(*m_pEnc, pText, iTextLen, llBits); break;
+	case 4: StreamBits<4>(*m_pEnc, pText, iTextLen, llBits); break;
+	case 8: StreamBits<8>(*m_pEnc, pText, iTextLen, llBits); break;
+	default: StreamBits<16>(*m_pEnc, pText, iTextLen, llBits); break;
+	}
+
+	long long llBytes[HFM_MAX_STREAMS];
+	long long llTotal = 0;
+	for(int k=0; k<N; k++)
+	{
+		// 码长表与第0路共用位流
+		llBytes[k] = (llBits[k] + (k == 0 ? clcoder.GetBits() : 0) + 7) / 8;
+		llTotal += llBytes[k];
+	}
+
+	vecHdr[0] |= HFM_FRAME_MULTI;
+	HfmPutVarint(vecHdr, (unsigned long long)N);
+	for(int k=1; k<N; k++)
+	{
+		HfmPutVarint(vecHdr, (unsigned long long)llBytes[k]);
+	}
+
+	int iHdrLen = (int)vecHdr.size();
+	char * pOut = nullptr;
+	if(iHdrLen + llTotal > 0x7FFFFFFF || !AllocOut(iHdrLen + llTotal, pOut))
+	{
+		return -1;
+	}
+
+	int iEnTextLen = iHdrLen + (int)llTotal;
+	unsigned char * pEnText = (unsigned char *)pOut;
+	memcpy(pEnText, &vecHdr[0], iHdrLen);
+
+	CBitWriter writers[HFM_MAX_STREAMS];
+	unsigned char * pStream = pEnText + iHdrLen;
+	for(int k=0; k<N; k++)
+	{
+		writers[k].Attach(pStream);
+		pStream += llBytes[k];
+	}
+
+	clcoder.Write(writers[0]);
+
+	switch(N)
+	{
+	case 2: EncodeStreams<2>(*m_pEnc, pText, iTextLen, writers); break;
+	case 4: EncodeStreams<4>(*m_pEnc, pText, iTextLen, writers); break;
+	case 8: EncodeStreams<8>(*m_pEnc, pText, iTextLen, writers); break;
+	default: EncodeStreams<16>(*m_pEnc, pText, iTextLen, writers); break;
+	}
+
+	for(int k=0; k<N; k++)
+	{
+		writers[k].Flush();
+	}
+
+	*ppOutput = (char *)pEnText;
+	*pOutputLen = iEnTextLen;
+
+	return iEnTextLen;
+}
+
+// N路子流各自的位数: 第i个元素属于第i % N路
+template<typename _EL, typename _WT>
+template<int N>
+void CHuffmanCodec<_EL, _WT>::StreamBits(const CHfmEncTable<_EL> & table, const _EL * pText, int iTextLen, long long * pBits)
+{
+	for(int k=0; k<N; k++)
+	{
+		pBits[k] = 0;
+	}
+
+	for(int beg=0; beg<iTextLen; beg+=HFM_STREAM_CHUNK)
+	{
+		int end = min(beg + HFM_STREAM_CHUNK, iTextLen);
+		for(int k=0; k<N; k++)
+		{
+			long long bits = 0;
+			for(int i=beg+k; i<end; i+=N)
+			{
+				bits += table.Find(pText[i]).len;
+			}
+			pBits[k] += bits;
+		}
+	}
+}
+
+/*N路子流编码: 按HFM_STREAM_CHUNK个元素分块, 块内逐路以步长N写入;
+  每路的写入器在块内是局部变量, 可留在寄存器中, 不随写出的字节反复读写内存*/
+template<typename _EL, typename _WT>
+template<int N>
+void CHuffmanCodec<_EL, _WT>::EncodeStreams(const CHfmEncTable<_EL> & table, const _EL * pText, int iTextLen, CBitWriter * pWriters)
+{
+	for(int beg=0; beg<iTextLen; beg+=HFM_STREAM_CHUNK)
+	{
+		int end = min(beg + HFM_STREAM_CHUNK, iTextLen);
+		for(int k=0; k<N; k++)
+		{
+			CBitWriter writer = pWriters[k];
+			for(int i=beg+k; i<end; i+=N)
+			{
+				table.Put(writer, pText[i]);
+			}
+			pWriters[k] = writer;
+		}
+	}
+}
+
+// 码书帧编码: 码表全部来自码书, 只需查表写位流
+template<typename _EL, typename _WT>
+int CHuffmanCodec<_EL, _WT>::EncodeWithBook(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen)
+{
+	if(m_pBook->IsEmpty())
+	{
+		return -1;
+	}
+
+	unsigned char hdr[11];
+	hdr[0] = HFM_FRAME_CODEBOOK;
+	int iHdrLen = (int)(HfmPutVarint(hdr + 1, (unsigned long long)iTextLen) - hdr);
+
+	long long llBits = m_pBook->GetBits(pText, iTextLen);
+	char * pOut = nullptr;
+	if(iHdrLen + (llBits + 7) / 8 > 0x7FFFFFFF || !AllocOut(iHdrLen + (llBits + 7) / 8, pOut))
+	{
+		return -1;
+	}
+
+	int iEnTextLen = iHdrLen + (int)((llBits + 7) / 8);
+	unsigned char * pEnText = (unsigned char *)pOut;
+	memcpy(pEnText, hdr, iHdrLen);
+
+	CBitWriter writer(pEnText + iHdrLen);
+	m_pBook->Write(writer, pText, iTextLen);
+	writer.Flush();
+
+	*ppOutput = (char *)pEnText;
+	*pOutputLen = iEnTextLen;
+
+	return iEnTextLen;
+}
+
+// 码书帧帧头之后的数据, count个元素写入pOut
+template<typename _EL, typename _WT>
+template<typename _OT>
+bool CHuffmanCodec<_EL, _WT>::DecodeBookData(const unsigned char * p, const unsigned char * end, int count, _OT * pOut, const CHuffmanCodebook<_EL> * pBook)
+{
+	if(pBook == nullptr || pBook->IsEmpty())
+	{
+		return false;
+	}
+
+	CBitReader reader(p, (int)(end - p));
+	return pBook->Read(reader, count, pOut);
+}
+
+// 自适应哈夫曼编码, 输出为单个位流; 输出到调用方缓冲时直接写入, 否则先收集再分配
+template<typename _EL, typename _WT>
+int CHuffmanCodec<_EL, _WT>::EncodeAdaptive(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen)
+{
+	vector<char> vecOut;
+	long long llLen = 0;
+	CHuffmanAdaptive<_EL> adaptive;
+
+	adaptive.EncodeBegin([&](const char * pData, size_t iLen){
+		if(m_bUserOut)
+		{
+			if(llLen + (long long)iLen > m_iUserCap)
+			{
+				return false;
+			}
+			memcpy((char *)m_pUserOut + llLen, pData, iLen);
+		}
+		else
+		{
+			vecOut.insert(vecOut.end(), pData, pData + iLen);
+		}
+		llLen += iLen;
+		return llLen <= 0x7FFFFFFF;
+	});
+	if(!adaptive.EncodeFeed(pText, (size_t)max(iTextLen, 0)) || !adaptive.EncodeFinish())
+	{
+		return -1;
+	}
+
+	char * pEnText = nullptr;
+	if(!AllocOut(llLen, pEnText))
+	{
+		return -1;
+	}
+	if(!m_bUserOut && llLen > 0)
+	{
+		memcpy(pEnText, &vecOut[0], (size_t)llLen);
+	}
+
+	*ppOutput = pEnText;
+	*pOutputLen = (int)llLen;
+
+	return (int)llLen;
+}
+
+template<typename _EL, typename _WT>
+template<typename _OT>
+int CHuffmanCodec<_EL, _WT>::DecodeAdaptive(const char * pData, int iDataLen, _OT ** ppOutput, int * pOutputLen)
+{
+	vector<_OT> vecOut;
+	long long llLen = 0;
+	CHuffmanAdaptive<_EL> adaptive;
+
+	adaptive.DecodeBegin([&](const _EL * pElems, size_t iLen){
+		if(m_bUserOut)
+		{
+			if(llLen + (long long)iLen > m_iUserCap)
+			{
+				return false;
+			}
+			_OT * pUser = (_OT *)m_pUserOut;
+			for(size_t i=0; i<iLen; i++)
+			{
+				pUser[llLen + i] = (_OT)pElems[i];
+			}
+		}
+		else
+		{
+			for(size_t i=0; i<iLen; i++)
+			{
+				vecOut.push_back((_OT)pElems[i]);
+			}
+		}
+		llLen += iLen;
+		return llLen <= 0x7FFFFFFF;
+	});
+	if(!adaptive.DecodeFeed(pData, (size_t)iDataLen) || !adaptive.DecodeFinish())
+	{
+		return -1;
+	}
+
+	int iDeTextLen = (int)llLen;
+	_OT * pDeText = nullptr;
+	if(!AllocOut(iDeTextLen, pDeText))
+	{
+		return -1;
+	}
+	if(!m_bUserOut && iDeTextLen > 0)
+	{
+		memcpy(pDeText, &vecOut[0], iDeTextLen * sizeof(_OT));
+	}
+	EndText(pDeText, iDeTextLen);
+
+	*ppOutput = pDeText;
+	*pOutputLen = iDeTextLen;
+
+	return iDeTextLen;
+}
+
+// 读帧头: 类型和元素个数
+template<typename _EL, typename _WT>
+bool CHuffmanCodec<_EL, _WT>::ReadFrameHead(const unsigned char *& p, const unsigned char * end, unsigned char & type, int & count)
+{
+	unsigned long long v = 0;
+
+	if(end - p < 2)
+	{
+		return false;
+	}
+
+	type = *p++;
+	if(!HfmGetVarint(p, end, v) || v > 0x7FFFFFFF)
+	{
+		return false;
+	}
+
+	count = (int)v;
+	return true;
+}
+
+// 解码哈夫曼编码帧帧头之后的部分, count个元素写入pOut
+template<typename _EL, typename _WT>
+template<typename _OT>
+bool CHuffmanCodec<_EL, _WT>::DecodeFrameData(const unsigned char * p, const unsigned char * end, unsigned char type, int count, _OT * pOut, _FrameDec & dec)
+{
+	unsigned long long n = 0;
+
+	if(count <= 0)
+	{
+		return true;
+	}
+
+	if(!HfmGetVarint(p, end, n) || n == 0 || n > (unsigned long long)count || n > (1 << 24))
+	{
+		return false;
+	}
+
+	// 转义时码长表末尾多一项转义码, 不分子流
+	int esc = (type & HFM_FRAME_ESCAPE) ? (int)n : -1;
+	int size = (int)n + (esc >= 0 ? 1 : 0);
+	if(esc >= 0 && (type & HFM_FRAME_MULTI))
+	{
+		return false;
+	}
+
+	dec.lens.resize((size_t)size);
+	if(!HfmReadElems(p, end, type, (int)n, dec.elems))
+	{
+		return false;
+	}
+
+	// 多路子流: 由跳转表从尾部倒推各路的起始位置
+	unsigned long long N = 1;
+	unsigned long long len[HFM_MAX_STREAMS] = {0};
+	if(type & HFM_FRAME_MULTI)
+	{
+		if(!HfmGetVarint(p, end, N) || N < 2 || N > HFM_MAX_STREAMS || (N & (N - 1)) != 0)
+		{
+			return false;
+		}
+
+		unsigned long long sum = 0;
+		for(unsigned long long k=1; k<N; k++)
+		{
+			if(!HfmGetVarint(p, end, len[k]) || len[k] > (unsigned long long)(end - p))
+			{
+				return false;
+			}
+			sum += len[k];
+		}
+		if(sum > (unsigned long long)(end - p))
+		{
+			return false;
+		}
+		len[0] = (unsigned long long)(end - p) - sum;
+	}
+	else
+	{
+		len[0] = (unsigned long long)(end - p);
+	}
+
+	CBitReader readers[HFM_MAX_STREAMS];
+	const unsigned char * q = p;
+	for(int k=0; k<(int)N; k++)
+	{
+		readers[k].Attach(q, (int)len[k]);
+		q += len[k];
+	}
+
+	CBitReader & reader = readers[0];
+	if(!CCodeLenCoder::Read(reader, (type & HFM_FRAME_CL_HUFF) != 0, &dec.lens[0], size, &dec.cltable))
+	{
+		return false;
+	}
+
+	// 帧头的元素表和码长命中码表缓存时直接用缓存的解码表
+	dec.set.reset();
+	dec.pTable = &dec.table;
+	if(dec.pCache != nullptr)
+	{
+		dec.set = dec.pCache->Find(&dec.elems[0], (int)n, &dec.lens[0], size, dec.table.GetTableBits());
+		if(!dec.set)
+		{
+			return false;
+		}
+		dec.pTable = &dec.set->dec;
+	}
+	else if(!dec.table.Build(&dec.lens[0], size))
+	{
+		return false;
+	}
+	const CHuffmanDecTable & table = *dec.pTable;
+
+#ifdef HFM_SIMD_X86
+	if(N >= 4 && HfmSimdLevel() != HFM_SIMD_NONE && count >= (int)N * HFM_SIMD_MIN_ROUNDS
+		&& table.GetMaxLen() <= table.GetTableBits())
+	{
+		return DecodeStreamsSimd((int)N, p, end, len, readers, count, pOut, dec);
+	}
+#endif
+
+	switch(N)
+	{
+	case 2: return DecodeStreams<2>(readers, count, pOut, dec);
+	case 4: return DecodeStreams<4>(readers, count, pOut, dec);
+	case 8: return DecodeStreams<8>(readers, count, pOut, dec);
+	case 16: return DecodeStreams<16>(readers, count, pOut, dec);
+	default: break;
+	}
+
+	for(int i=0; i<count; i++)
+	{
+		reader.Refill();
+		int idx = table.DecodeOne(reader);
+		if(idx < 0)
+		{
+			return false;
+		}
+
+		pOut[i] = (idx == esc) ? (_OT)HfmReadRaw<_EL>(reader) : (_OT)dec.elems[idx];
+	}
+
+	return true;
+}
+
+// N路子流交错解码: 各路之间没有依赖, 一轮内N次查表可同时进行
+template<typename _EL, typename _WT>
+template<int N, typename _OT>
+bool CHuffmanCodec<_EL, _WT>::DecodeStreams(CBitReader * pReaders, int count, _OT * pOut, _FrameDec & dec)
+{
+	const _EL * pElems = &dec.elems[0];
+	const CHuffmanDecTable & table = *dec.pTable;
+	int i = 0;
+
+	// 读取器放在局部变量中, 写输出不会迫使编译器重新读取其状态, 各路查表得以重叠
+	CBitReader readers[N];
+	for(int k=0; k<N; k++)
+	{
+		readers[k] = pReaders[k];
+	}
+
+	for(; i+N<=count; i+=N)
+	{
+		int idx[N];
+		for(int g=0; g<N; g+=HFM_STREAM_GROUP)
+		{
+			DecodeRound(readers + g, table, idx + g, make_index_sequence<(N < HFM_STREAM_GROUP ? N : HFM_STREAM_GROUP)>());
+		}
+
+		for(int k=0; k<N; k++)
+		{
+			if(idx[k] < 0)
+			{
+				return false;
+			}
+			pOut[i + k] = (_OT)pElems[idx[k]];
+		}
+	}
+
+	for(int k=0; i<count; i++, k++)
+	{
+		readers[k].Refill();
+		int idx = table.DecodeOne(readers[k]);
+		if(idx < 0)
+		{
+			return false;
+		}
+		pOut[i] = (_OT)pElems[idx];
+	}
+
+	return true;
+}
+
+#ifdef HFM_SIMD_X86
+/*多路子流SIMD解码: 各路位置换算为相对第0路起点的字节偏移和位偏移, 交给SIMD核心;
+  核心在任一路接近帧尾时停止, 余下部分由各路读取器接着标量解码*/
+template<typename _EL, typename _WT>
+template<typename _OT>
+bool CHuffmanCodec<_EL, _WT>::DecodeStreamsSimd(int N, const unsigned char * p, const unsigned char * end, const unsigned long long * pLens,
+	CBitReader * pReaders, int count, _OT * pOut, _FrameDec & dec)
+{
+	int iOff[HFM_MAX_STREAMS];
+	int iSh[HFM_MAX_STREAMS];
+	long long llStart[HFM_MAX_STREAMS + 1];
+
+	llStart[0] = 0;
+	for(int k=0; k<N; k++)
+	{
+		llStart[k+1] = llStart[k] + (long long)pLens[k];
+
+		// 第0路已读过码长表
+		long long pos = (k == 0) ? pReaders[0].GetBitPos() : 0;
+		iOff[k] = (int)(llStart[k] + (pos >> 3));
+		iSh[k] = (int)(pos & 7);
+	}
+
+	int iLimit = (int)(end - p) - 4;
+	int rounds = count / N;
+	int done = 0;
+
+	const unsigned int * pTable = dec.pTable->GetTable();
+	int iTableBits = dec.pTable->GetTableBits();
+
+	int level = HfmSimdLevel();
+	if(level >= HFM_SIMD_AVX2 && N == 16)
+	{
+		done = HfmDecodeAvx2<16>(p, iOff, iSh, iLimit, pTable, iTableBits, &dec.elems[0], pOut, rounds);
+	}
+	else if(level >= HFM_SIMD_AVX2 && N == 8)
+	{
+		done = HfmDecodeAvx2<8>(p, iOff, iSh, iLimit, pTable, iTableBits, &dec.elems[0], pOut, rounds);
+	}
+	else if(N == 16)
+	{
+		done = HfmDecodeSse41<16>(p, iOff, iSh, iLimit, pTable, iTableBits, &dec.elems[0], pOut, rounds);
+	}
+	else if(N == 8)
+	{
+		done = HfmDecodeSse41<8>(p, iOff, iSh, iLimit, pTable, iTableBits, &dec.elems[0], pOut, rounds);
+	}
+	else
+	{
+		done = HfmDecodeSse41<4>(p, iOff, iSh, iLimit, pTable, iTableBits, &dec.elems[0], pOut, rounds);
+	}
+
+	if(done < 0)
+	{
+		return false;
+	}
+
+	// 各路读取器定位到SIMD停止的位置; 越过本路结尾说明数据错误
+	for(int k=0; k<N; k++)
+	{
+		if(iOff[k] > llStart[k+1])
+		{
+			return false;
+		}
+		pReaders[k].Attach(p + iOff[k], (int)(llStart[k+1] - iOff[k]));
+		pReaders[k].Skip(iSh[k]);
+	}
+
+	int rest = count - done * N;
+	_OT * pRest = pOut + done * N;
+
+	switch(N)
+	{
+	case 16: return DecodeStreams<16>(pReaders, rest, pRest, dec);
+	case 8: return DecodeStreams<8>(pReaders, rest, pRest, dec);
+	default: return DecodeStreams<4>(pReaders, rest, pRest, dec);
+	}
+}
+#endif
+
+// 自描述帧解码, 只凭帧内的元素表和码长重建范式编码
+template<typename _EL, typename _WT>
+template<typename _OT>
+int CHuffmanCodec<_EL, _WT>::DecodeFrame(const unsigned char * pData, int iDataLen, _OT ** ppOutput, int * pOutputLen)
+{
+	const unsigned char * p = pData;
+	const unsigned char * end = pData + iDataLen;
+	unsigned char type = 0;
+	int iDeTextLen = 0;
+
+	if(!ReadFrameHead(p, end, type, iDeTextLen))
+	{
+		return -1;
+	}
+	if((type & HFM_FRAME_TYPE_MASK) == HFM_FRAME_BLOCKS)
+	{
+		return DecodeBlocks(pData, iDataLen, ppOutput, pOutputLen);
+	}
+	if((type & HFM_FRAME_TYPE_MASK) != HFM_FRAME_HUFFMAN && (type & HFM_FRAME_TYPE_MASK) != HFM_FRAME_CODEBOOK)
+	{
+		return -1;
+	}
+
+	// 每个元素至少1位
+	if((unsigned long long)iDeTextLen > (unsigned long long)(end - p) * 8)
+	{
+		return -1;
+	}
+
+	_OT * pDeText = nullptr;
+	if(!AllocOut(iDeTextLen, pDeText))
+	{
+		return -1;
+	}
+	bool bok = ((type & HFM_FRAME_TYPE_MASK) == HFM_FRAME_CODEBOOK)
+		? DecodeBookData(p, end, iDeTextLen, pDeText, m_pBook)
+		: DecodeFrameData(p, end, type, iDeTextLen, pDeText, m_frm);
+	if(!bok)
+	{
+		FreeOut(pDeText);
+		return -1;
+	}
+
+	EndText(pDeText, iDeTextLen);
+
+	*ppOutput = pDeText;
+	*pOutputLen = iDeTextLen;
+
+	return iDeTextLen;
+}
+
+// 分块编码: 各块用独立的编码器并行编码为帧, 写块索引后依次拼接
+// 各块编码器和帧缓冲保留在本对象中, 下条消息复用
+template<typename _EL, typename _WT>
+int CHuffmanCodec<_EL, _WT>::EncodeBlocks(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen)
+{
+	int nblocks = (int)(((long long)iTextLen + m_iBlockSize - 1) / m_iBlockSize);
+	vector<int> & vecLen = m_vecBlkLen;
+	vecLen.assign(nblocks, -1);
+	if(m_vecBlkOut.size() < (size_t)nblocks)
+	{
+		m_vecBlkOut.resize(nblocks);
+	}
+
+	auto fnBlock = [&](int k){
+		int beg = (int)((long long)m_iBlockSize * k);
+		int len = min(m_iBlockSize, iTextLen - beg);
+
+		_BlockCtx * ctx = AcquireBlockCtx();
+		CHuffmanCodec<_EL, _WT> & codec = *ctx->codec;
+		codec.SetFormat(HFM_FMT_FRAME);
+		codec.SetCodeLenLimit(m_iLimit, m_iLimitMode);
+		codec.SetStreams(m_iStreams);
+		codec.SetEscape(m_iEscTopK);
+		codec.SetCodebook(m_pBook);
+		codec.SetCodeCache(m_pCache);
+
+		vector<char> & vecOut = m_vecBlkOut[k];
+		long long llBound = codec.GetEncodeBound(len);
+		if(llBound <= 0x7FFFFFFF)
+		{
+			if(vecOut.size() < (size_t)llBound)
+			{
+				vecOut.resize((size_t)llBound);
+			}
+			vecLen[k] = codec.EncodeTo(pText + beg, len, &vecOut[0], (int)vecOut.size());
+		}
+		ReleaseBlockCtx(ctx);
+	};
+
+	if(m_iBlockThreads == 1)
+	{
+		for(int k=0; k<nblocks; k++)
+		{
+			fnBlock(k);
+		}
+	}
+	else
+	{
+		(m_pPool ? *m_pPool : CHfmThreadPool::Default()).ParallelFor(nblocks, fnBlock);
+	}
+
+	vector<unsigned char> & vecHdr = m_vecHdr;
+	vecHdr.clear();
+	vecHdr.push_back(HFM_FRAME_BLOCKS);
+	HfmPutVarint(vecHdr, (unsigned long long)iTextLen);
+	HfmPutVarint(vecHdr, (unsigned long long)nblocks);
+
+	long long llTotal = 0;
+	for(int k=0; k<nblocks; k++)
+	{
+		if(vecLen[k] < 0)
+		{
+			return -1;
+		}
+
+		int beg = (int)((long long)m_iBlockSize * k);
+		HfmPutVarint(vecHdr, (unsigned long long)vecLen[k]);
+		HfmPutVarint(vecHdr, (unsigned long long)min(m_iBlockSize, iTextLen - beg));
+		llTotal += vecLen[k];
+	}
+
+	char * pOut = nullptr;
+	if(llTotal + vecHdr.size() > 0x7FFFFFFF || !AllocOut((long long)vecHdr.size() + llTotal, pOut))
+	{
+		return -1;
+	}
+
+	unsigned char * pEnText = (unsigned char *)pOut;
+	unsigned char * p = pEnText;
+	memcpy(p, &vecHdr[0], vecHdr.size());
+	p += vecHdr.size();
+
+	for(int k=0; k<nblocks; k++)
+	{
+		memcpy(p, &m_vecBlkOut[k][0], vecLen[k]);
+		p += vecLen[k];
+	}
+
+	*ppOutput = (char *)pEnText;
+	*pOutputLen = (int)(p - pEnText);
+
+	return *pOutputLen;
+}
+
+// 分块帧解码: 由块索引算出各块的帧位置和输出位置, 各块并行解码到输出的对应位置
+template<typename _EL, typename _WT>
+template<typename _OT>
+int CHuffmanCodec<_EL, _WT>::DecodeBlocks(const unsigned char * pData, int iDataLen, _OT ** ppOutput, int * pOutputLen)
+{
+	const unsigned char * p = pData;
+	const unsigned char * end = pData + iDataLen;
+	unsigned char type = 0;
+	int iDeTextLen = 0;
+	unsigned long long nblocks = 0;
+
+	// 每块索引至少2字节, 据此限制块数
+	if(!ReadFrameHead(p, end, type, iDeTextLen)
+		|| !HfmGetVarint(p, end, nblocks) || nblocks == 0 || nblocks > (unsigned long long)iDeTextLen
+		|| nblocks > (unsigned long long)(end - p) / 2)
+	{
+		return -1;
+	}
+
+	int nblk = (int)nblocks;
+	vector<long long> & vecFrmPos = m_vecBlkFrmPos;
+	vector<int> & vecOutPos = m_vecBlkOutPos;
+	vecFrmPos.resize(nblk + 1);
+	vecOutPos.resize(nblk + 1);
+
+	vecFrmPos[0] = 0;
+	vecOutPos[0] = 0;
+	for(int k=0; k<nblk; k++)
+	{
+		unsigned long long len = 0;
+		unsigned long long cnt = 0;
+		if(!HfmGetVarint(p, end, len) || !HfmGetVarint(p, end, cnt)
+			|| len == 0 || len > (unsigned long long)(end - p) || cnt == 0 || cnt > (unsigned long long)(iDeTextLen - vecOutPos[k]))
+		{
+			return -1;
+		}
+		vecFrmPos[k+1] = vecFrmPos[k] + (long long)len;
+		vecOutPos[k+1] = vecOutPos[k] + (int)cnt;
+	}
+
+	if(vecFrmPos[nblk] != end - p || vecOutPos[nblk] != iDeTextLen)
+	{
+		return -1;
+	}
+
+	_OT * pDeText = nullptr;
+	if(!AllocOut(iDeTextLen, pDeText))
+	{
+		return -1;
+	}
+	atomic<bool> bok(true);
+	int iTableBits = m_frm.table.GetTableBits();
+
+	auto fnBlock = [&](int k){
+		const unsigned char * q = p + vecFrmPos[k];
+		const unsigned char * qend = p + vecFrmPos[k+1];
+		unsigned char btype = 0;
+		int bcount = 0;
+
+		// 块帧只能是哈夫曼编码帧或码书帧, 不允许嵌套分块; 元素个数须与索引一致
+		if(!ReadFrameHead(q, qend, btype, bcount) || bcount != vecOutPos[k+1] - vecOutPos[k])
+		{
+			bok = false;
+			return;
+		}
+		if((btype & HFM_FRAME_TYPE_MASK) == HFM_FRAME_CODEBOOK)
+		{
+			if(!DecodeBookData(q, qend, bcount, pDeText + vecOutPos[k], m_pBook))
+			{
+				bok = false;
+			}
+			return;
+		}
+
+		_BlockCtx * ctx = AcquireBlockCtx();
+		_FrameDec & dec = ctx->dec;
+		dec.table.SetTableBits(iTableBits);
+		dec.pCache = m_pCache;
+		if((btype & HFM_FRAME_TYPE_MASK) != HFM_FRAME_HUFFMAN
+			|| !DecodeFrameData(q, qend, btype, bcount, pDeText + vecOutPos[k], dec))
+		{
+			bok = false;
+		}
+		ReleaseBlockCtx(ctx);
+	};
+
+	if(m_iBlockThreads == 1)
+	{
+		for(int k=0; k<nblk && bok; k++)
+		{
+			fnBlock(k);
+		}
+	}
+	else
+	{
+		(m_pPool ? *m_pPool : CHfmThreadPool::Default()).ParallelFor(nblk, fnBlock);
+	}
+
+	if(!bok)
+	{
+		FreeOut(pDeText);
+		return -1;
+	}
+
+	EndText(pDeText, iDeTextLen);
+
+	*ppOutput = pDeText;
+	*pOutputLen = iDeTextLen;
+
+	return iDeTextLen;
+}
+
+template<typename _EL, typename _WT>
+bool CHuffmanCodec<_EL, _WT>::EncodeBegin(const _ByteSink & sink)
+{
+	m_stmByteSink = sink;
+	m_vecStmElems.clear();
+	m_llStmIn = 0;
+	m_llStmOut = 0;
+	m_iStmState = 1;
+
+	char type = HFM_FRAME_STREAM;
+	if(!m_stmByteSink(&type, 1))
+	{
+		m_iStmState = -1;
+		return false;
+	}
+	m_llStmOut = 1;
+
+	return true;
+}
+
+template<typename _EL, typename _WT>
+bool CHuffmanCodec<_EL, _WT>::EncodeFeed(const _EL * pText, size_t iTextLen)
+{
+	if(m_iStmState != 1)
+	{
+		return false;
+	}
+
+	size_t block = (m_iBlockSize > 0) ? (size_t)m_iBlockSize : HFM_STREAM_BLOCK;
+
+	while(iTextLen > 0)
+	{
+		size_t len = min(iTextLen, block - m_vecStmElems.size());
+		m_vecStmElems.insert(m_vecStmElems.end(), pText, pText + len);
+		pText += len;
+		iTextLen -= len;
+		m_llStmIn += len;
+
+		if(m_vecStmElems.size() == block && !StreamEncodeBlock())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template<typename _EL, typename _WT>
+bool CHuffmanCodec<_EL, _WT>::EncodeFlush()
+{
+	if(m_iStmState != 1)
+	{
+		return false;
+	}
+
+	return m_vecStmElems.empty() || StreamEncodeBlock();
+}
+
+template<typename _EL, typename _WT>
+bool CHuffmanCodec<_EL, _WT>::EncodeFinish()
+{
+	if(!EncodeFlush())
+	{
+		return false;
+	}
+
+	char end = 0;
+	if(!m_stmByteSink(&end, 1))
+	{
+		m_iStmState = -1;
+		return false;
+	}
+	m_llStmOut++;
+	m_iStmState = 2;
+
+	return true;
+}
+
+// 缓存的输入编码为一帧写出
+template<typename _EL, typename _WT>
+bool CHuffmanCodec<_EL, _WT>::StreamEncodeBlock()
+{
+	// 帧编码器跨帧、跨流保留, 每帧EncodeTo时复位
+	if(!m_pStmCodec)
+	{
+		m_pStmCodec.reset(new CHuffmanCodec<_EL, _WT>());
+	}
+	CHuffmanCodec<_EL, _WT> & codec = *m_pStmCodec;
+	codec.SetFormat(HFM_FMT_FRAME);
+	codec.SetCodeLenLimit(m_iLimit, m_iLimitMode);
+	codec.SetStatThreads(m_iStatThreads);
+	codec.SetThreadPool(m_pPool);
+	codec.SetStreams(m_iStreams);
+	codec.SetEscape(m_iEscTopK);
+	codec.SetCodebook(m_pBook);
+	codec.SetCodeCache(m_pCache);
+
+	// 帧缓冲按上限分配, 各帧复用
+	int count = (int)m_vecStmElems.size();
+	long long llBound = codec.GetEncodeBound(count);
+	if(llBound > 0x7FFFFFFF)
+	{
+		m_iStmState = -1;
+		return false;
+	}
+	if(m_vecStmFrame.size() < (size_t)llBound)
+	{
+		m_vecStmFrame.resize((size_t)llBound);
+	}
+
+	int iFrameLen = codec.EncodeTo(&m_vecStmElems[0], count, &m_vecStmFrame[0], (int)m_vecStmFrame.size());
+	if(iFrameLen < 0)
+	{
+		m_iStmState = -1;
+		return false;
+	}
+
+	unsigned char hdr[10];
+	int iHdrLen = (int)(HfmPutVarint(hdr, (unsigned long long)iFrameLen) - hdr);
+	bool bok = m_stmByteSink((const char *)hdr, iHdrLen) && m_stmByteSink(&m_vecStmFrame[0], iFrameLen);
+
+	if(!bok)
+	{
+		m_iStmState = -1;
+		return false;
+	}
+
+	m_llStmOut += iHdrLen + iFrameLen;
+	m_vecStmElems.clear();
+
+	return true;
+}
+
+template<typename _EL, typename _WT>
+bool CHuffmanCodec<_EL, _WT>::DecodeBegin(const _ElemSink & sink)
+{
+	m_stmElemSink = sink;
+	m_vecStmBytes.clear();
+	m_iStmPos = 0;
+	m_llStmIn = 0;
+	m_llStmOut = 0;
+	m_iStmState = 0;
+
+	return true;
+}
+
+template<typename _EL, typename _WT>
+bool CHuffmanCodec<_EL, _WT>::DecodeFeed(const char * pData, size_t iDataLen)
+{
+	if(m_iStmState < 0 || (m_iStmState == 2 && iDataLen > 0))
+	{
+		m_iStmState = -1;
+		return false;
+	}
+
+	// 已处理的部分过半时前移, 缓存不超过一帧加一次输入
+	if(m_iStmPos > 0 && m_iStmPos * 2 >= m_vecStmBytes.size())
+	{
+		m_vecStmBytes.erase(m_vecStmBytes.begin(), m_vecStmBytes.begin() + m_iStmPos);
+		m_iStmPos = 0;
+	}
+
+	m_vecStmBytes.insert(m_vecStmBytes.end(), (const unsigned char *)pData, (const unsigned char *)pData + iDataLen);
+	m_llStmIn += iDataLen;
+
+	if(!StreamDecodeFrames())
+	{
+		m_iStmState = -1;
+		return false;
+	}
+
+	return true;
+}
+
+template<typename _EL, typename _WT>
+bool CHuffmanCodec<_EL, _WT>::DecodeFinish()
+{
+	return m_iStmState == 2 && m_iStmPos == m_vecStmBytes.size();
+}
+
+// 解码缓存中所有完整的帧, 不完整的留待下次输入
+template<typename _EL, typename _WT>
+bool CHuffmanCodec<_EL, _WT>::StreamDecodeFrames()
+{
+	const unsigned char * base = m_vecStmBytes.empty() ? nullptr : &m_vecStmBytes[0];
+	const unsigned char * end = base + m_vecStmBytes.size();
+
+	if(m_iStmState == 0)
+	{
+		if(m_iStmPos == m_vecStmBytes.size())
+		{
+			return true;
+		}
+		if(base[m_iStmPos] != HFM_FRAME_STREAM)
+		{
+			return false;
+		}
+		m_iStmPos++;
+		m_iStmState = 1;
+	}
+
+	while(m_iStmState == 1 && m_iStmPos < m_vecStmBytes.size())
+	{
+		const unsigned char * p = base + m_iStmPos;
+		unsigned long long len = 0;
+
+		if(!HfmGetVarint(p, end, len))
+		{
+			// 长度不完整时等待, 超过10字节为数据错误
+			return end - (base + m_iStmPos) < 10;
+		}
+		if(len == 0)
+		{
+			m_iStmPos = p - base;
+			m_iStmState = 2;
+			return m_iStmPos == m_vecStmBytes.size();
+		}
+		if(len > HFM_STREAM_MAX_FRAME)
+		{
+			return false;
+		}
+		if(len > (unsigned long long)(end - p))
+		{
+			return true;
+		}
+
+		const unsigned char * q = p;
+		const unsigned char * qend = p + len;
+		unsigned char type = 0;
+		int count = 0;
+
+		// 每个元素至少1位
+		if(!ReadFrameHead(q, qend, type, count)
+			|| ((type & HFM_FRAME_TYPE_MASK) != HFM_FRAME_HUFFMAN && (type & HFM_FRAME_TYPE_MASK) != HFM_FRAME_CODEBOOK)
+			|| (unsigned long long)count > len * 8)
+		{
+			return false;
+		}
+
+		m_vecStmElems.resize(count);
+		if(count > 0)
+		{
+			bool bok = ((type & HFM_FRAME_TYPE_MASK) == HFM_FRAME_CODEBOOK)
+				? DecodeBookData(q, qend, count, &m_vecStmElems[0], m_pBook)
+				: DecodeFrameData(q, qend, type, count, &m_vecStmElems[0], m_frm);
+			if(!bok || !m_stmElemSink(&m_vecStmElems[0], count))
+			{
+				return false;
+			}
+		}
+
+		m_llStmOut += count;
+		m_iStmPos = qend - base;
+	}
+
+	return true;
+}
+
+template<typename _EL, typename _WT>
+int CHuffmanCodec<_EL, _WT>::Decode(_EL * pText, int iTextLen, char ** ppOutput, int * pOutputLen)
+{
+	return DecodeAs(pText, iTextLen, ppOutput, pOutputLen);
+}
+
+template<typename _EL, typename _WT>
+template<typename _BT, typename _OT>
+int CHuffmanCodec<_EL, _WT>::DecodeAs(const _BT * pText, int iTextLen, _OT ** ppOutput, int * pOutputLen)
+{
+	if(m_iFormat == HFM_FMT_PACKED)
+	{
+		return DecodePacked((const unsigned char *)pText, iTextLen, ppOutput, pOutputLen);
+	}
+	if(m_iFormat == HFM_FMT_FRAME)
+	{
+		return DecodeFrame((const unsigned char *)pText, iTextLen, ppOutput, pOutputLen);
+	}
+	if(m_iFormat == HFM_FMT_ADAPTIVE)
+	{
+		return DecodeAdaptive((const char *)pText, iTextLen, ppOutput, pOutputLen);
+	}
+
+	// 0位即0个元素, 此时没有解码树
+	if(iTextLen <= 0)
+	{
+		return EmptyOut(ppOutput, pOutputLen);
+	}
+
+	// 逐位走扁平解码树, 直接写入输出; 每个元素至少1位, 自行分配时按位数分配
+	const CHfmFlatTree & tree = this->GetFlatTree();
+	if(tree.IsEmpty())
+	{
+		return -1;
+	}
+
+	_OT * pDeText = nullptr;
+	if(!m_bUserOut && !AllocOut(iTextLen, pDeText))
+	{
+		return -1;
+	}
+
+	_OutSpan<_OT> out;
+	out.p = out.beg = m_bUserOut ? (_OT *)m_pUserOut : pDeText;
+	out.end = out.p + (m_bUserOut ? m_iUserCap : iTextLen);
+	out.over = false;
+	if(!tree.Decode(pText, iTextLen, m_pElems, out) || out.over)
+	{
+		FreeOut(pDeText);
+		return -1;
+	}
+
+	pDeText = out.beg;
+	int iDeTextLen = (int)(out.p - out.beg);
+	EndText(pDeText, iDeTextLen);
+
+	*ppOutput = pDeText;
+	*pOutputLen = iDeTextLen;
+	
+	return iDeTextLen;
+}
+
+template<typename _EL, typename _WT>
+int CHuffmanCodec<_EL, _WT>::EncodeTo(_EL * pText, int iTextLen, char * pOut, int iOutCap)
+{
+	char * pOutput = nullptr;
+	int iOutputLen = 0;
+
+	m_pUserOut = pOut;
+	m_iUserCap = max(iOutCap, 0);
+	m_bUserOut = true;
+	int ret = Encode(pText, iTextLen, &pOutput, &iOutputLen);
+	m_bUserOut = false;
+	m_pUserOut = nullptr;
+	m_iUserCap = 0;
+
+	return ret;
+}
+
+template<typename _EL, typename _WT>
+int CHuffmanCodec<_EL, _WT>::DecodeTo(_EL * pText, int iTextLen, char * pOut, int iOutCap)
+{
+	char * pOutput = nullptr;
+	int iOutputLen = 0;
+
+	m_pUserOut = pOut;
+	m_iUserCap = max(iOutCap, 0);
+	m_bUserOut = true;
+	int ret = Decode(pText, iTextLen, &pOutput, &iOutputLen);
+	m_bUserOut = false;
+	m_pUserOut = nullptr;
+	m_iUserCap = 0;
+
+	return ret;
+}
+
+template<typename _EL, typename _WT>
+int CHuffmanCodec<_EL, _WT>::DecodeElems(const char * pData, int iDataLen, _EL ** ppOutput, int * pOutputLen)
+{
+	return DecodeAs(pData, iDataLen, ppOutput, pOutputLen);
+}
+
+template<typename _EL, typename _WT>
+int CHuffmanCodec<_EL, _WT>::DecodeElems(const char * pData, int iDataLen, _EL * pOut, int iOutCap)
+{
+	_EL * pOutput = nullptr;
+	int iOutputLen = 0;
+
+	m_pUserOut = pOut;
+	m_iUserCap = max(iOutCap, 0);
+	m_bUserOut = true;
+	int ret = DecodeAs(pData, iDataLen, &pOutput, &iOutputLen);
+	m_bUserOut = false;
+	m_pUserOut = nullptr;
+	m_iUserCap = 0;
+
+	return ret;
+}
+
+/*单帧的最大长度: 帧头 + 元素表 + 码长表 + 数据
+  n个不同元素时最优码不长于定长码的ceil(log2(n))位, 限长时不超过限长, 转义元素另加原值位数; 码书帧每元素不超过码书最大位数*/
+template<typename _EL, typename _WT>
+long long CHuffmanCodec<_EL, _WT>::GetFrameBound(int iTextLen)
+{
+	const int RAW_BITS = 8 * sizeof(_EL);
+	long long llLen = 1 + 10;
+
+	if(iTextLen <= 0)
+	{
+		return llLen;
+	}
+
+	if(m_pBook != nullptr)
+	{
+		return llLen + ((long long)iTextLen * m_pBook->GetMaxBits() + 7) / 8;
+	}
+
+	long long n = (RAW_BITS < 31) ? min((long long)iTextLen, 1LL << RAW_BITS) : (long long)iTextLen;
+	int bits = max(min(RAW_BITS, 31), m_iLimit) + ((m_iEscTopK > 0) ? RAW_BITS : 0);
+
+	llLen += 10 + n * ((RAW_BITS + 6) / 7 + 1) + (6 * n + 7) / 8;
+	llLen += ((long long)iTextLen * bits + 7) / 8;
+	if(m_iStreams > 1)
+	{
+		llLen += 10LL * m_iStreams + m_iStreams;
+	}
+
+	return llLen;
+}
+
+template<typename _EL, typename _WT>
+long long CHuffmanCodec<_EL, _WT>::GetEncodeBound(int iTextLen)
+{
+	const int RAW_BITS = 8 * sizeof(_EL);
+	long long llText = max(iTextLen, 0);
+	int bits = max(min(RAW_BITS, 31), m_iLimit);
+
+	if(m_iFormat == HFM_FMT_BITCHAR)
+	{
+		return llText * bits;
+	}
+	if(m_iFormat == HFM_FMT_PACKED)
+	{
+		return (llText * (bits + ((m_iEscTopK > 0) ? RAW_BITS : 0)) + 7) / 8;
+	}
+	if(m_iFormat == HFM_FMT_ADAPTIVE)
+	{
+		// 树深不超过叶子数减1, 叶子为已出现的元素和NYT; 新元素为NYT路径+1位+原值, 结束标记为NYT路径+1位
+		long long depth = (RAW_BITS < 31) ? min(llText, 1LL << RAW_BITS) : llText;
+		return ((llText + 1) * (depth + 1 + RAW_BITS) + 7) / 8;
+	}
+
+	if(m_iBlockSize > 0 && iTextLen > m_iBlockSize)
+	{
+		long long nblocks = (llText + m_iBlockSize - 1) / m_iBlockSize;
+		long long llLen = 1 + 10 + 10 + nblocks * 20;
+		llLen += (nblocks - 1) * GetFrameBound(m_iBlockSize);
+		llLen += GetFrameBound((int)(llText - (nblocks - 1) * m_iBlockSize));
+		return llLen;
+	}
+
+	return GetFrameBound(iTextLen);
+}
+
+template<typename _EL, typename _WT>
+int CHuffmanCodec<_EL, _WT>::GetDecodedSize(const char * pData, int iDataLen)
+{
+	if(m_iFormat == HFM_FMT_PACKED)
+	{
+		return m_iTextLen;
+	}
+	if(m_iFormat != HFM_FMT_FRAME)
+	{
+		return -1;
+	}
+
+	const unsigned char * p = (const unsigned char *)pData;
+	unsigned char type = 0;
+	int count = 0;
+	if(!ReadFrameHead(p, p + max(iDataLen, 0), type, count))
+	{
+		return -1;
+	}
+
+	type &= HFM_FRAME_TYPE_MASK;
+	if(type != HFM_FRAME_HUFFMAN && type != HFM_FRAME_CODEBOOK && type != HFM_FRAME_BLOCKS)
+	{
+		return -1;
+	}
+	return count;
+}
+
+/** 
+// test code
+char g_text[] = "ADFHFAAAAHFGKKKKJJJJJJJJJJEEvkwwuuuuu";
+
+void CHuffmanDemoDlg::OnBnClickedButton1()
+{
+	// TODO: 在此添加控件通知处理程序代码
+	TRACE("text:%s\r\n", g_text); 
+	CHuffmanCodec<char, int> hfmCodec;
+	char * pOutput;
+	int iOutputLen;
+	int textlen = strlen(g_text);
+	int len = hfmCodec.Encode(g_text, textlen, &pOutput, &iOutputLen);
+	TRACE("encode:");
+	for(int i=0; i<iOutputLen; i++)
+	{
+		TRACE("%d", pOutput[i]);
+		if((1+i)%130==0)
+			TRACE("\r\n");
+	}
+
+	TRACE("\r\ntext bit count: %d, after encoding:%d \r\n", textlen * 8, iOutputLen);
+
+	char * pText;// = new char[1];
+	int iTextLen;
+	int len2 = hfmCodec.Decode(pOutput, iOutputLen, &pText, &iTextLen);
+	TRACE("decode:%s\r\n", pText);
+
+	delete[] pOutput;
+	delete[] pText;
+	
+}
+
+debugging output:
+text:ADFHFAAAAHFGKKKKJJJJJJJJJJEEvkwwuuuuu
+Elem: A, D, E, F, G, H, J, K, k, u, v, w, 
+Len: 5, 1, 2, 3, 1, 2, 10, 4, 1, 5, 1, 2, 
+idx: 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 
+00 -- idx:6, cnt:10, code len:2, id:0 - huffman code
+010 -- idx:0, cnt:5, code len:3, id:1 - huffman code
+011 -- idx:7, cnt:4, code len:3, id:2 - huffman code
+100 -- idx:9, cnt:5, code len:3, id:3 - huffman code
+1010 -- idx:2, cnt:2, code len:4, id:4 - huffman code
+1011 -- idx:3, cnt:3, code len:4, id:5 - huffman code
+1100 -- idx:5, cnt:2, code len:4, id:6 - huffman code
+1101 -- idx:11, cnt:2, code len:4, id:7 - huffman code
+11100 -- idx:1, cnt:1, code len:5, id:8 - huffman code
+11101 -- idx:4, cnt:1, code len:5, id:9 - huffman code
+11110 -- idx:8, cnt:1, code len:5, id:10 - huffman code
+11111 -- idx:10, cnt:1, code len:5, id:11 - huffman code
+encode:0101110010111100101101001001001011001011111010110110110110000000000000000000010101010111111111011011101100100100100100
+text bit count: 296, after encoding:118 
+decode:ADFHFAAAAHFGKKKKJJJJJJJJJJEEvkwwuuuuu
+**/
+
+/** 
+// benchmark code: creat()建树耗时与元素种类数的关系
+#include <chrono>
+
+void BenchCreat()
+{
+	for(int size=256; size<=(1<<20); size*=4)
+	{
+		vector<long long> w(size);
+		srand(size);
+		for(int i=0; i<size; i++)
+		{
+			w[i] = 1 + rand() % 100000;
+		}
+
+		CHuffman<long long> huff;
+		auto t0 = chrono::steady_clock::now();
+		huff.creat(&w[0], size);
+		auto t1 = chrono::steady_clock::now();
+		huff.destroy();
+
+		TRACE("size: %d, creat: %.3f ms\r\n", size, chrono::duration<double, milli>(t1 - t0).count());
+	}
+}
+
+benchmark output (g++ -O2, x86-64), 单位ms:
+size        每轮全排序     排序一次+双队列合并
+256              1.457          0.066
+1024            29.290          0.172
+4096           602.818          0.778
+16384        11185.210          3.497
+65536                -         20.922
+262144               -        106.320
+1048576              -        597.778
+**/
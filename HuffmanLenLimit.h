@@ -0,0 +1,212 @@
+
+// HuffmanLenLimit.h : 限长哈夫曼码长计算, Huffman.h 和 Huffman_limit_len.h 共用
+//
+
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
+using namespace std;
+
+
+// 码长限制方式
+enum
+{
+	HFM_LIMIT_PACKAGE_MERGE = 0,	// package-merge, 限长下最优
+	HFM_LIMIT_KRAFT,				// 截断后按Kraft不等式调整, 快速, 接近最优
+};
+
+// 限长是否可行: n个元素至少需要ceil(log2(n))位; n不超过int, 31位及以上总是可行
+inline bool HfmLimitFeasible(int n, int iLimit)
+{
+	if(n <= 1)
+	{
+		return iLimit >= 1;
+	}
+	return iLimit >= 31 || (1LL << iLimit) >= n;
+}
+
+// 按权值升序(相同按索引)排列的索引
+template<typename T>
+void HfmSortByWeight(const T * w, int n, vector<int> & vecIdx)
+{
+	vecIdx.resize(n);
+	for(int i=0; i<n; i++)
+	{
+		vecIdx[i] = i;
+	}
+	sort(vecIdx.begin(), vecIdx.end(), [w](int a, int b){return w[a] < w[b] || (!(w[b] < w[a]) && a < b);});
+}
+
+/*package-merge: 最长码长不超过iLimit的最优码长
+  自iLimit层向上, 每层将叶子与下一层两两打包的结果归并; 第1层取前2n-2项,
+  再逐层回溯: 每层取到的叶子码长加1, 取到的包数的两倍为下一层要取的项数*/
+template<typename T>
+bool HfmLimitPackageMerge(const T * w, int n, int iLimit, int * pLens)
+{
+	typedef typename conditional<numeric_limits<T>::is_integer, long long, double>::type _ST;
+
+	if(!HfmLimitFeasible(n, iLimit))
+	{
+		return false;
+	}
+	if(n == 1)
+	{
+		pLens[0] = 1;
+		return true;
+	}
+
+	vector<int> vecIdx;
+	HfmSortByWeight(w, n, vecIdx);
+
+	vector<_ST> vecLeaf(n);
+	for(int i=0; i<n; i++)
+	{
+		vecLeaf[i] = (_ST)w[vecIdx[i]];
+	}
+
+	// vecFlags[l]: 第l层归并后各项是否为叶子
+	vector<vector<unsigned char>> vecFlags(iLimit + 1);
+	vector<_ST> vecPrev;
+	vector<_ST> vecCur;
+
+	for(int l=iLimit; l>=1; l--)
+	{
+		size_t npkg = vecPrev.size() / 2;
+		size_t i = 0;
+		size_t j = 0;
+
+		vecCur.clear();
+		vecFlags[l].clear();
+		vecCur.reserve(n + npkg);
+		vecFlags[l].reserve(n + npkg);
+
+		while(i < (size_t)n || j < npkg)
+		{
+			// 权值相同时优先取叶子
+			if(j >= npkg || (i < (size_t)n && !(vecPrev[2*j] + vecPrev[2*j+1] < vecLeaf[i])))
+			{
+				vecCur.push_back(vecLeaf[i++]);
+				vecFlags[l].push_back(1);
+			}
+			else
+			{
+				vecCur.push_back(vecPrev[2*j] + vecPrev[2*j+1]);
+				vecFlags[l].push_back(0);
+				j++;
+			}
+		}
+
+		vecPrev.swap(vecCur);
+	}
+
+	vector<int> vecLens(n, 0);
+	size_t take = 2 * (size_t)n - 2;
+
+	for(int l=1; l<=iLimit && take > 0; l++)
+	{
+		size_t leaves = 0;
+		for(size_t k=0; k<take; k++)
+		{
+			leaves += vecFlags[l][k];
+		}
+
+		// 取到的叶子总是最小的leaves个
+		for(size_t k=0; k<leaves; k++)
+		{
+			vecLens[k]++;
+		}
+
+		take = 2 * (take - leaves);
+	}
+
+	for(int i=0; i<n; i++)
+	{
+		pLens[vecIdx[i]] = vecLens[i];
+	}
+
+	return true;
+}
+
+/*Kraft调整: pLens输入为不限长的码长, 输出不超过iLimit
+  超长码截断到iLimit后Kraft和溢出, 从权值小的元素起加长码长直到不溢出,
+  再从权值大的元素起利用剩余空间缩短码长*/
+template<typename T>
+bool HfmLimitKraft(const T * w, int n, int iLimit, int * pLens)
+{
+	if(!HfmLimitFeasible(n, iLimit))
+	{
+		return false;
+	}
+	if(n == 1)
+	{
+		pLens[0] = 1;
+		return true;
+	}
+
+	vector<int> vecIdx;
+	HfmSortByWeight(w, n, vecIdx);
+
+	const long long full = 1LL << iLimit;
+	long long kraft = 0;
+
+	for(int i=0; i<n; i++)
+	{
+		pLens[i] = min(pLens[i], iLimit);
+		kraft += 1LL << (iLimit - pLens[i]);
+	}
+
+	// 加长: 从长码到短码, 同码长先动权值小的; 全部为iLimit时必不溢出, 循环必然结束
+	while(kraft > full)
+	{
+		for(int l=iLimit-1; l>=1 && kraft > full; l--)
+		{
+			for(int k=0; k<n && kraft > full; k++)
+			{
+				int & len = pLens[vecIdx[k]];
+				if(len == l)
+				{
+					len++;
+					kraft -= 1LL << (iLimit - len);
+				}
+			}
+		}
+	}
+
+	// 缩短: 权值大的优先
+	for(int k=n-1; k>=0; k--)
+	{
+		int & len = pLens[vecIdx[k]];
+		while(len > 1 && kraft + (1LL << (iLimit - len)) <= full)
+		{
+			kraft += 1LL << (iLimit - len);
+			len--;
+		}
+	}
+
+	return kraft <= full;
+}
+
+// 将码长限制在iLimit以内, iMode: HFM_LIMIT_PACKAGE_MERGE / HFM_LIMIT_KRAFT
+template<typename T>
+bool HfmLimitCodeLens(const T * w, int n, int iLimit, int iMode, int * pLens)
+{
+	int maxlen = 0;
+	for(int i=0; i<n; i++)
+	{
+		maxlen = max(maxlen, pLens[i]);
+	}
+	if(maxlen <= iLimit)
+	{
+		return true;
+	}
+
+	if(iMode == HFM_LIMIT_KRAFT)
+	{
+		return HfmLimitKraft(w, n, iLimit, pLens);
+	}
+	return HfmLimitPackageMerge(w, n, iLimit, pLens);
+}
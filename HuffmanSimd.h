@@ -0,0 +1,271 @@
+
+// HuffmanSimd.h : 多路交错子流的SIMD查表解码(AVX2 / SSE4.1), 运行时按CPU选择
+//
+
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HFM_SIMD_X86
+#endif
+
+#ifdef HFM_SIMD_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#define HFM_TARGET_AVX2
+#define HFM_TARGET_SSE41
+#else
+#include <cpuid.h>
+#include <immintrin.h>
+#define HFM_TARGET_AVX2		__attribute__((target("avx2")))
+#define HFM_TARGET_SSE41	__attribute__((target("sse4.1")))
+#endif
+#endif
+
+
+// SIMD级别
+enum
+{
+	HFM_SIMD_NONE = 0,
+	HFM_SIMD_SSE41,
+	HFM_SIMD_AVX2,
+};
+
+#define HFM_SIMD_MIN_ROUNDS		64		// 每路元素少于此数时不用SIMD
+
+// 检测CPU和操作系统支持的SIMD级别
+inline int HfmDetectSimd()
+{
+#ifdef HFM_SIMD_X86
+	unsigned int a = 0, b = 0, c = 0, d = 0;
+#ifdef _MSC_VER
+	int regs[4];
+	__cpuid(regs, 0);
+	unsigned int maxleaf = (unsigned int)regs[0];
+	__cpuid(regs, 1);
+	c = (unsigned int)regs[2];
+#else
+	unsigned int maxleaf = __get_cpuid_max(0, nullptr);
+	if(maxleaf < 1)
+	{
+		return HFM_SIMD_NONE;
+	}
+	__cpuid(1, a, b, c, d);
+#endif
+
+	if((c & (1u << 19)) == 0)
+	{
+		return HFM_SIMD_NONE;
+	}
+
+	// AVX2: CPU支持AVX/AVX2, 且操作系统保存YMM寄存器(OSXSAVE + XCR0)
+	bool bAvx2 = false;
+	if((c & (1u << 27)) && (c & (1u << 28)) && maxleaf >= 7)
+	{
+#ifdef _MSC_VER
+		unsigned long long xcr0 = _xgetbv(0);
+		__cpuidex(regs, 7, 0);
+		b = (unsigned int)regs[1];
+#else
+		unsigned int lo = 0, hi = 0;
+		__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		unsigned long long xcr0 = ((unsigned long long)hi << 32) | lo;
+		__cpuid_count(7, 0, a, b, c, d);
+#endif
+		bAvx2 = ((xcr0 & 6) == 6) && (b & (1u << 5));
+	}
+
+	return bAvx2 ? HFM_SIMD_AVX2 : HFM_SIMD_SSE41;
+#else
+	return HFM_SIMD_NONE;
+#endif
+}
+
+// 当前SIMD级别的存储, 首次调用时检测; 解码线程会并发读取, 故为原子变量
+inline std::atomic<int> & HfmSimdLevelVar()
+{
+	static std::atomic<int> level(HfmDetectSimd());
+	return level;
+}
+
+// 当前使用的SIMD级别
+inline int HfmSimdLevel()
+{
+	return HfmSimdLevelVar().load(std::memory_order_relaxed);
+}
+
+// 强制使用较低级别的实现, 不超过检测到的级别; 可在其他线程解码时调用
+inline void HfmSetSimdLevel(int iLevel)
+{
+	static const int detected = HfmDetectSimd();
+	HfmSimdLevelVar().store(iLevel < detected ? iLevel : detected, std::memory_order_relaxed);
+}
+
+#ifdef HFM_SIMD_X86
+
+/*AVX2: 每8路子流一组, 各路占一个32位通道; N为8或16, 16路时两组的依赖链交错, 掩盖gather延迟
+  每轮按各路字节偏移gather 4字节, 转为大端后左移位偏移, 取高iTableBits位再gather一级表;
+  要求最长码长不超过iTableBits, 一级表即可解出全部码字
+  pOff/pSh: 各路相对pBase的字节偏移和位偏移, 返回时更新; 任一路字节偏移超过iLimit即停止
+  返回解码的轮数(每轮每路一个元素), 遇到非法码返回-1*/
+template<int N, typename _EL, typename _OT>
+HFM_TARGET_AVX2 int HfmDecodeAvx2(const unsigned char * pBase, int * pOff, int * pSh, int iLimit,
+	const unsigned int * pTable, int iTableBits, const _EL * pElems, _OT * pOut, int iRounds)
+{
+	const int G = N / 8;
+	const __m256i bswap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+										   3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	const __m256i limit = _mm256_set1_epi32(iLimit);
+	const __m256i lenmask = _mm256_set1_epi32(0x3F);
+	const __m256i seven = _mm256_set1_epi32(7);
+	const __m128i cnt = _mm_cvtsi32_si128(32 - iTableBits);
+
+	__m256i off[G];
+	__m256i sh[G];
+	for(int g=0; g<G; g++)
+	{
+		off[g] = _mm256_loadu_si256((const __m256i *)(pOff + 8 * g));
+		sh[g] = _mm256_loadu_si256((const __m256i *)(pSh + 8 * g));
+	}
+
+	alignas(32) unsigned int idx[N];
+	int r = 0;
+
+	for(; r<iRounds; r++)
+	{
+		int over = 0;
+		for(int g=0; g<G; g++)
+		{
+			over |= _mm256_movemask_epi8(_mm256_cmpgt_epi32(off[g], limit));
+		}
+		if(over != 0)
+		{
+			break;
+		}
+
+		int bad = 0;
+		for(int g=0; g<G; g++)
+		{
+			__m256i w = _mm256_i32gather_epi32((const int *)pBase, off[g], 1);
+			w = _mm256_sllv_epi32(_mm256_shuffle_epi8(w, bswap), sh[g]);
+			__m256i e = _mm256_i32gather_epi32((const int *)pTable, _mm256_srl_epi32(w, cnt), 4);
+
+			__m256i len = _mm256_and_si256(e, lenmask);
+			bad |= _mm256_movemask_epi8(_mm256_cmpeq_epi32(len, _mm256_setzero_si256()));
+
+			__m256i bits = _mm256_add_epi32(sh[g], len);
+			off[g] = _mm256_add_epi32(off[g], _mm256_srli_epi32(bits, 3));
+			sh[g] = _mm256_and_si256(bits, seven);
+
+			_mm256_store_si256((__m256i *)(idx + 8 * g), _mm256_srli_epi32(e, 8));
+		}
+		if(bad != 0)
+		{
+			return -1;
+		}
+
+		_OT * pDst = pOut + N * r;
+		for(int k=0; k<N; k++)
+		{
+			pDst[k] = (_OT)pElems[idx[k]];
+		}
+	}
+
+	for(int g=0; g<G; g++)
+	{
+		_mm256_storeu_si256((__m256i *)(pOff + 8 * g), off[g]);
+		_mm256_storeu_si256((__m256i *)(pSh + 8 * g), sh[g]);
+	}
+
+	return r;
+}
+
+/*SSE4.1: 每4路一组, 没有gather, 逐通道取数; 按位偏移左移用乘2^sh代替
+  参数和返回值同HfmDecodeAvx2, N为4、8或16*/
+template<int N, typename _EL, typename _OT>
+HFM_TARGET_SSE41 int HfmDecodeSse41(const unsigned char * pBase, int * pOff, int * pSh, int iLimit,
+	const unsigned int * pTable, int iTableBits, const _EL * pElems, _OT * pOut, int iRounds)
+{
+	const int G = N / 4;
+	const __m128i bswap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+	const __m128i limit = _mm_set1_epi32(iLimit);
+	const __m128i lenmask = _mm_set1_epi32(0x3F);
+	const __m128i seven = _mm_set1_epi32(7);
+	const __m128i bias = _mm_set1_epi32(127);
+	const __m128i cnt = _mm_cvtsi32_si128(32 - iTableBits);
+
+	__m128i off[G];
+	__m128i sh[G];
+	for(int g=0; g<G; g++)
+	{
+		off[g] = _mm_loadu_si128((const __m128i *)(pOff + 4 * g));
+		sh[g] = _mm_loadu_si128((const __m128i *)(pSh + 4 * g));
+	}
+
+	alignas(16) int o[4];
+	alignas(16) unsigned int ix[4];
+	alignas(16) unsigned int idx[4];
+	int r = 0;
+
+	for(; r<iRounds; r++)
+	{
+		int over = 0;
+		for(int g=0; g<G; g++)
+		{
+			over |= _mm_movemask_epi8(_mm_cmpgt_epi32(off[g], limit));
+		}
+		if(over != 0)
+		{
+			break;
+		}
+
+		_OT * pDst = pOut + N * r;
+		for(int g=0; g<G; g++)
+		{
+			unsigned int v[4];
+			_mm_store_si128((__m128i *)o, off[g]);
+			for(int k=0; k<4; k++)
+			{
+				memcpy(&v[k], pBase + o[k], 4);
+			}
+
+			// 2^sh: 由浮点数指数位构造
+			__m128i pow2 = _mm_cvttps_epi32(_mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(sh[g], bias), 23)));
+			__m128i w = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)v), bswap);
+			w = _mm_mullo_epi32(w, pow2);
+
+			_mm_store_si128((__m128i *)ix, _mm_srl_epi32(w, cnt));
+			__m128i e = _mm_setr_epi32((int)pTable[ix[0]], (int)pTable[ix[1]], (int)pTable[ix[2]], (int)pTable[ix[3]]);
+
+			__m128i len = _mm_and_si128(e, lenmask);
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(len, _mm_setzero_si128())) != 0)
+			{
+				return -1;
+			}
+
+			__m128i bits = _mm_add_epi32(sh[g], len);
+			off[g] = _mm_add_epi32(off[g], _mm_srli_epi32(bits, 3));
+			sh[g] = _mm_and_si128(bits, seven);
+
+			_mm_store_si128((__m128i *)idx, _mm_srli_epi32(e, 8));
+			for(int k=0; k<4; k++)
+			{
+				pDst[4 * g + k] = (_OT)pElems[idx[k]];
+			}
+		}
+	}
+
+	for(int g=0; g<G; g++)
+	{
+		_mm_storeu_si128((__m128i *)(pOff + 4 * g), off[g]);
+		_mm_storeu_si128((__m128i *)(pSh + 4 * g), sh[g]);
+	}
+
+	return r;
+}
+
+#endif
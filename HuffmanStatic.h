@@ -0,0 +1,287 @@
+
+// HuffmanStatic.h : 编译期哈夫曼码表, 分布固定的字段在编译期算出码长、范式码字和解码表
+//
+
+
+#pragma once
+
+#include "Huffman.h"
+
+
+/*编译期码表: N个元素(元素值0..N-1)的权值表在编译期算出限长码长、范式码字和单级解码表
+  码长算法与运行时相同: 按(权值, 索引)升序后Moffat-Katajainen计算, 超过L位时按Kraft不等式调整;
+  权值为0的元素按1计, 保证每个元素都可编码
+  码长不超过L, 解码只需查一次2^L项的表; 表项 (索引<<8)|码长, 0为非法码*/
+template<int N, int L = HFM_TABLE_BITS>
+struct CHfmStaticCode
+{
+	static_assert(N >= 1 && L >= 1 && L <= 16, "CHfmStaticCode: 1 <= L <= 16");
+	static_assert(N <= (1 << L), "CHfmStaticCode: L位容纳不下N个元素");
+
+	unsigned long long	codes[N];			// 范式码字, 右对齐
+	int					lens[N];			// 码长
+	unsigned int		table[1 << L];		// 解码表
+	int					maxlen;				// 最长码长
+
+	template<typename W>
+	constexpr CHfmStaticCode(const W (&freq)[N])
+		:codes(), lens(), table(), maxlen(0)
+	{
+		// 按(权值, 索引)升序排列的索引, 与HfmSortByWeight一致
+		unsigned long long w[N] = {};
+		int idx[N] = {};
+		for(int i=0; i<N; i++)
+		{
+			w[i] = (freq[i] > 0) ? (unsigned long long)freq[i] : 1;
+			idx[i] = i;
+		}
+		for(int i=1; i<N; i++)
+		{
+			int k = idx[i];
+			int j = i - 1;
+			while(j >= 0 && w[idx[j]] > w[k])
+			{
+				idx[j+1] = idx[j];
+				j--;
+			}
+			idx[j+1] = k;
+		}
+
+		unsigned long long A[N] = {};
+		for(int i=0; i<N; i++)
+		{
+			A[i] = w[idx[i]];
+		}
+		CalcCodeLens(A, N);
+		for(int i=0; i<N; i++)
+		{
+			lens[idx[i]] = (A[i] > 0) ? (int)A[i] : 1;
+		}
+
+		LimitKraft(idx);
+
+		// 范式码字: 同HfmCanonicCodes
+		int count[L+1] = {};
+		unsigned long long next[L+1] = {};
+		for(int i=0; i<N; i++)
+		{
+			count[lens[i]]++;
+			maxlen = (lens[i] > maxlen) ? lens[i] : maxlen;
+		}
+		unsigned long long code = 0;
+		count[0] = 0;
+		for(int l=1; l<=L; l++)
+		{
+			code = (code + count[l-1]) << 1;
+			next[l] = code;
+		}
+		for(int i=0; i<N; i++)
+		{
+			codes[i] = next[lens[i]]++;
+		}
+
+		// 单级解码表: 码字c(码长l)占 [c<<(L-l), (c+1)<<(L-l))
+		for(int i=0; i<N; i++)
+		{
+			unsigned long long beg = codes[i] << (L - lens[i]);
+			unsigned long long end = (codes[i] + 1) << (L - lens[i]);
+			for(unsigned long long k=beg; k<end; k++)
+			{
+				table[k] = ((unsigned int)i << 8) | (unsigned int)lens[i];
+			}
+		}
+	}
+
+private:
+	// 同CHuffman::CalcCodeLens, A[]为升序权值, 完成后为码长
+	static constexpr void CalcCodeLens(unsigned long long * A, int n)
+	{
+		if(n == 1)
+		{
+			A[0] = 0;
+			return;
+		}
+
+		int root = 0;
+		int leaf = 2;
+		int next = 1;
+
+		A[0] += A[1];
+		for(next=1; next<n-1; next++)
+		{
+			if(leaf >= n || A[root] < A[leaf])
+			{
+				A[next] = A[root];
+				A[root++] = (unsigned long long)next;
+			}
+			else
+			{
+				A[next] = A[leaf++];
+			}
+
+			if(leaf >= n || (root < next && A[root] < A[leaf]))
+			{
+				A[next] += A[root];
+				A[root++] = (unsigned long long)next;
+			}
+			else
+			{
+				A[next] += A[leaf++];
+			}
+		}
+
+		A[n-2] = 0;
+		for(next=n-3; next>=0; next--)
+		{
+			A[next] = A[(int)A[next]] + 1;
+		}
+
+		int avbl = 1;
+		int used = 0;
+		int dpth = 0;
+		root = n - 2;
+		next = n - 1;
+		while(avbl > 0)
+		{
+			while(root >= 0 && (int)A[root] == dpth)
+			{
+				used++;
+				root--;
+			}
+			while(avbl > used)
+			{
+				A[next--] = (unsigned long long)dpth;
+				avbl--;
+			}
+			avbl = 2 * used;
+			dpth++;
+			used = 0;
+		}
+	}
+
+	// 同HfmLimitKraft: 截断到L位后从权值小的元素起加长, 再从权值大的元素起缩短
+	constexpr void LimitKraft(const int * idx)
+	{
+		const long long full = 1LL << L;
+		long long kraft = 0;
+
+		for(int i=0; i<N; i++)
+		{
+			lens[i] = (lens[i] < L) ? lens[i] : L;
+			kraft += 1LL << (L - lens[i]);
+		}
+
+		while(kraft > full)
+		{
+			for(int l=L-1; l>=1 && kraft > full; l--)
+			{
+				for(int k=0; k<N && kraft > full; k++)
+				{
+					if(lens[idx[k]] == l)
+					{
+						lens[idx[k]]++;
+						kraft -= 1LL << (L - lens[idx[k]]);
+					}
+				}
+			}
+		}
+
+		for(int k=N-1; k>=0; k--)
+		{
+			while(lens[idx[k]] > 1 && kraft + (1LL << (L - lens[idx[k]])) <= full)
+			{
+				kraft += 1LL << (L - lens[idx[k]]);
+				lens[idx[k]]--;
+			}
+		}
+	}
+};
+
+/*编译期编解码器: _FT::freq 为constexpr权值数组, 下标即元素值
+  码表在编译期算出并放在只读数据中, 没有启动开销; 编解码为静态内联函数
+  数据为紧凑位流(高位在前), 不含帧头, 元素个数由调用方保存
+  用法:
+	struct CMsgTypeFreq { static constexpr unsigned int freq[] = {900, 50, 30, 20}; };
+	typedef CHuffmanStatic<CMsgTypeFreq> CMsgTypeCodec;*/
+template<typename _FT, int L = HFM_TABLE_BITS>
+class CHuffmanStatic
+{
+public:
+	enum { SIZE = sizeof(_FT::freq) / sizeof(_FT::freq[0]), TABLE_BITS = L };
+	typedef CHfmStaticCode<SIZE, L> _Code;
+
+	static constexpr int GetMaxLen(){ return m_code.maxlen; }
+	static constexpr int GetCodeLen(int iSym){ return m_code.lens[iSym]; }
+	static constexpr unsigned long long GetCode(int iSym){ return m_code.codes[iSym]; }
+	// iTextLen个元素编码后的最大字节数
+	static constexpr long long GetEncodeBound(int iTextLen){ return ((long long)iTextLen * m_code.maxlen + 7) / 8; }
+
+	// 写入位流; 元素值须在0..SIZE-1之间
+	template<typename _EL>
+	static inline void Write(CBitWriter & writer, const _EL * pText, int iTextLen)
+	{
+		for(int i=0; i<iTextLen; i++)
+		{
+			int sym = (int)pText[i];
+			writer.PutBits(m_code.codes[sym], m_code.lens[sym]);
+		}
+	}
+
+	// 解码count个元素, 非法码返回false
+	template<typename _OT>
+	static inline bool Read(CBitReader & reader, int count, _OT * pOut)
+	{
+		for(int i=0; i<count; i++)
+		{
+			reader.Refill();
+			unsigned int e = m_code.table[reader.Peek(L)];
+			if(e == 0)
+			{
+				return false;
+			}
+			reader.Skip((int)(e & 0xFF));
+			pOut[i] = (_OT)(e >> 8);
+		}
+		return true;
+	}
+
+	// 编码到pOut, 返回字节数; 元素值越界或缓冲不足返回-1
+	template<typename _EL>
+	static int Encode(const _EL * pText, int iTextLen, char * pOut, int iOutCap)
+	{
+		long long llBits = 0;
+		for(int i=0; i<iTextLen; i++)
+		{
+			long long sym = (long long)pText[i];
+			if(sym < 0 || sym >= SIZE)
+			{
+				return -1;
+			}
+			llBits += m_code.lens[sym];
+		}
+		if((llBits + 7) / 8 > iOutCap)
+		{
+			return -1;
+		}
+
+		CBitWriter writer((unsigned char *)pOut);
+		Write(writer, pText, iTextLen);
+		writer.Flush();
+
+		return (int)((llBits + 7) / 8);
+	}
+
+	// 从iDataLen字节中解码iCount个元素到pOut, 数据不足或非法码返回false
+	template<typename _OT>
+	static bool Decode(const char * pData, int iDataLen, _OT * pOut, int iCount)
+	{
+		CBitReader reader((const unsigned char *)pData, iDataLen);
+		return Read(reader, iCount, pOut) && reader.GetBitPos() <= (long long)iDataLen * 8;
+	}
+
+private:
+	static constexpr _Code m_code = _Code(_FT::freq);
+};
+
+template<typename _FT, int L>
+constexpr typename CHuffmanStatic<_FT, L>::_Code CHuffmanStatic<_FT, L>::m_code;
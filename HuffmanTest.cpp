@@ -0,0 +1,721 @@
+// HuffmanTest.cpp : 编解码往返测试, 由ctest运行; 全部通过返回0
+//
+// 覆盖各输出格式和元素宽度、空输入和单一元素、分块、多路子流、限长、转义、
+// 流式分段输入、码书序列化、码表缓存、自适应编码和编译期码表, 并检查GetEncodeBound为上限
+//
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include "Huffman.h"
+#include "HuffmanStatic.h"
+
+
+static int g_iChecks = 0;
+static int g_iFails = 0;
+
+#define HFMT_CHECK(cond, what)	Check((cond), (what), #cond, __LINE__)
+
+static void Check(bool bok, const string & what, const char * pExpr, int iLine)
+{
+	g_iChecks++;
+	if(!bok)
+	{
+		g_iFails++;
+		printf("FAIL line %d: %s: %s\n", iLine, what.c_str(), pExpr);
+	}
+}
+
+// 固定种子的伪随机数, 各平台结果相同
+class CTestRand
+{
+public:
+	CTestRand(unsigned long long seed):m_s(seed * 0x9E3779B97F4A7C15ull + 1){}
+
+	unsigned long long Next()
+	{
+		m_s ^= m_s << 13;
+		m_s ^= m_s >> 7;
+		m_s ^= m_s << 17;
+		return m_s;
+	}
+	// [0, n)
+	unsigned long long Below(unsigned long long n){ return Next() % n; }
+
+private:
+	unsigned long long m_s;
+};
+
+// 测试数据: 空、单一元素、少量元素、偏斜分布(几何分布)、大字母表
+enum { DATA_EMPTY = 0, DATA_SINGLE, DATA_TWO, DATA_SKEWED, DATA_WIDE, DATA_KINDS };
+
+static const char * DataName(int iKind)
+{
+	static const char * names[DATA_KINDS] = {"empty", "single", "two", "skewed", "wide"};
+	return names[iKind];
+}
+
+template<typename _EL>
+static vector<_EL> MakeData(int iKind, int iLen, unsigned long long seed)
+{
+	typedef typename make_unsigned<_EL>::type _UT;
+	const int RAW_BITS = 8 * sizeof(_EL);
+	CTestRand rnd(seed);
+	vector<_EL> vec;
+
+	if(iKind == DATA_EMPTY)
+	{
+		return vec;
+	}
+
+	vec.resize(iLen);
+	for(int i=0; i<iLen; i++)
+	{
+		unsigned long long v = 0;
+		if(iKind == DATA_SINGLE)
+		{
+			v = 0x5A;
+		}
+		else if(iKind == DATA_TWO)
+		{
+			v = (rnd.Below(4) == 0) ? 3 : 200;
+		}
+		else if(iKind == DATA_SKEWED)
+		{
+			// 几何分布, 偶尔出现全宽度的值
+			while(v < 40 && rnd.Below(3) != 0)
+			{
+				v++;
+			}
+			if(rnd.Below(64) == 0)
+			{
+				v = rnd.Next();
+			}
+		}
+		else
+		{
+			v = rnd.Next() % (RAW_BITS <= 8 ? 256 : 3000);
+		}
+		if(RAW_BITS < 64)
+		{
+			v &= (1ULL << RAW_BITS) - 1;
+		}
+		vec[i] = (_EL)(_UT)v;
+	}
+
+	return vec;
+}
+
+// 编解码设置
+struct CTestCfg
+{
+	int		iFormat;
+	int		iBlockSize;
+	int		iBlockThreads;
+	int		iStreams;
+	int		iLimit;
+	int		iLimitMode;
+	int		iEscTopK;
+	const char *	pName;
+};
+
+template<typename _EL>
+static void Apply(CHuffmanCodec<_EL, long long> & codec, const CTestCfg & cfg)
+{
+	codec.SetFormat(cfg.iFormat);
+	codec.SetBlockSize(cfg.iBlockSize, cfg.iBlockThreads);
+	codec.SetStreams(cfg.iStreams);
+	codec.SetCodeLenLimit(cfg.iLimit, cfg.iLimitMode);
+	codec.SetEscape(cfg.iEscTopK);
+}
+
+// 一次往返: Encode/DecodeElems、EncodeTo/DecodeElems(调用方缓冲); 自描述格式用另一个对象解码
+template<typename _EL>
+static void RoundTrip(const CTestCfg & cfg, const vector<_EL> & vecText, const string & what)
+{
+	CHuffmanCodec<_EL, long long> enc;
+	CHuffmanCodec<_EL, long long> dec;
+	Apply(enc, cfg);
+	Apply(dec, cfg);
+
+	bool bSelf = (cfg.iFormat == HFM_FMT_FRAME || cfg.iFormat == HFM_FMT_ADAPTIVE);
+	CHuffmanCodec<_EL, long long> & decoder = bSelf ? dec : enc;
+
+	int iTextLen = (int)vecText.size();
+	_EL * pText = iTextLen > 0 ? const_cast<_EL *>(&vecText[0]) : nullptr;
+	long long llBound = enc.GetEncodeBound(iTextLen);
+
+	char * pOut = nullptr;
+	int iOutLen = -1;
+	int ret = enc.Encode(pText, iTextLen, &pOut, &iOutLen);
+	HFMT_CHECK(ret >= 0 && ret == iOutLen, what + " encode");
+	if(ret < 0)
+	{
+		return;
+	}
+	HFMT_CHECK(iOutLen <= llBound, what + " bound");
+
+	_EL * pDe = nullptr;
+	int iDeLen = -1;
+	ret = decoder.DecodeElems(pOut, iOutLen, &pDe, &iDeLen);
+	HFMT_CHECK(ret == iTextLen && iDeLen == iTextLen, what + " decode length");
+	HFMT_CHECK(ret == iTextLen && (iTextLen == 0 || memcmp(pDe, pText, iTextLen * sizeof(_EL)) == 0), what + " decode data");
+	delete[] pDe;
+
+	// 按上限分配的调用方缓冲, 输出须与Encode相同
+	vector<char> vecOut((size_t)llBound + 1);
+	int iToLen = enc.EncodeTo(pText, iTextLen, &vecOut[0], (int)llBound);
+	HFMT_CHECK(iToLen == iOutLen && memcmp(&vecOut[0], pOut, iOutLen) == 0, what + " encode to buffer");
+
+	vector<_EL> vecDe(iTextLen + 1);
+	ret = decoder.DecodeElems(&vecOut[0], iToLen, &vecDe[0], iTextLen);
+	HFMT_CHECK(ret == iTextLen && (iTextLen == 0 || memcmp(&vecDe[0], pText, iTextLen * sizeof(_EL)) == 0), what + " decode to buffer");
+
+	if(bSelf && cfg.iFormat == HFM_FMT_FRAME)
+	{
+		HFMT_CHECK(dec.GetDecodedSize(pOut, iOutLen) == iTextLen, what + " decoded size");
+	}
+
+	delete[] pOut;
+}
+
+static const CTestCfg g_cfgs[] =
+{
+	{HFM_FMT_BITCHAR,	0, 0, 1, 0, HFM_LIMIT_PACKAGE_MERGE, 0,		"bitchar"},
+	{HFM_FMT_PACKED,	0, 0, 1, 0, HFM_LIMIT_PACKAGE_MERGE, 0,		"packed"},
+	{HFM_FMT_PACKED,	0, 0, 1, 0, HFM_LIMIT_PACKAGE_MERGE, 8,		"packed escape"},
+	{HFM_FMT_FRAME,		0, 0, 1, 0, HFM_LIMIT_PACKAGE_MERGE, 0,		"frame"},
+	{HFM_FMT_FRAME,		0, 0, 1, 11, HFM_LIMIT_PACKAGE_MERGE, 0,	"frame limit pm"},
+	{HFM_FMT_FRAME,		0, 0, 1, 9, HFM_LIMIT_KRAFT, 0,				"frame limit kraft"},
+	{HFM_FMT_FRAME,		0, 0, 1, 0, HFM_LIMIT_PACKAGE_MERGE, 8,		"frame escape"},
+	{HFM_FMT_FRAME,		0, 0, 2, 0, HFM_LIMIT_PACKAGE_MERGE, 0,		"frame 2 streams"},
+	{HFM_FMT_FRAME,		0, 0, 4, 11, HFM_LIMIT_PACKAGE_MERGE, 0,	"frame 4 streams"},
+	{HFM_FMT_FRAME,		0, 0, 8, 11, HFM_LIMIT_PACKAGE_MERGE, 0,	"frame 8 streams"},
+	{HFM_FMT_FRAME,		0, 0, 16, 11, HFM_LIMIT_PACKAGE_MERGE, 0,	"frame 16 streams"},
+	{HFM_FMT_FRAME,		1000, 1, 1, 0, HFM_LIMIT_PACKAGE_MERGE, 0,	"frame blocks"},
+	{HFM_FMT_FRAME,		777, 0, 4, 12, HFM_LIMIT_KRAFT, 0,			"frame blocks pool"},
+	{HFM_FMT_FRAME,		1500, 0, 1, 0, HFM_LIMIT_PACKAGE_MERGE, 8,	"frame blocks escape"},
+	{HFM_FMT_ADAPTIVE,	0, 0, 1, 0, HFM_LIMIT_PACKAGE_MERGE, 0,		"adaptive"},
+};
+
+// 各格式、各设置与各种数据的往返
+template<typename _EL>
+static void TestFormats(const char * pType)
+{
+	const int lens[] = {1, 7, 5000};
+
+	for(size_t c=0; c<sizeof(g_cfgs)/sizeof(g_cfgs[0]); c++)
+	{
+		for(int k=0; k<DATA_KINDS; k++)
+		{
+			for(size_t l=0; l<sizeof(lens)/sizeof(lens[0]); l++)
+			{
+				if(k == DATA_EMPTY && l > 0)
+				{
+					continue;
+				}
+
+				// 限长不足以容纳大字母表时编码失败是预期的
+				const CTestCfg & cfg = g_cfgs[c];
+				if(k == DATA_WIDE && cfg.iLimit > 0 && cfg.iEscTopK == 0 && sizeof(_EL) > 1)
+				{
+					continue;
+				}
+
+				vector<_EL> vecText = MakeData<_EL>(k, lens[l], (unsigned long long)(c * 131 + k * 7 + l));
+				RoundTrip(cfg, vecText, string(pType) + " " + cfg.pName + " " + DataName(k) + " len " + to_string(vecText.size()));
+			}
+		}
+	}
+}
+
+// 多路子流在各SIMD级别下解码结果相同
+static void TestSimdLevels()
+{
+	int detected = HfmSimdLevel();
+	vector<unsigned char> vecText = MakeData<unsigned char>(DATA_SKEWED, 100000, 99);
+
+	for(int lv=detected; lv>=0; lv--)
+	{
+		HfmSetSimdLevel(lv);
+		for(size_t c=0; c<sizeof(g_cfgs)/sizeof(g_cfgs[0]); c++)
+		{
+			if(g_cfgs[c].iStreams >= 4)
+			{
+				RoundTrip(g_cfgs[c], vecText, string("simd level ") + to_string(lv) + " " + g_cfgs[c].pName);
+			}
+		}
+	}
+	HfmSetSimdLevel(detected);
+}
+
+// 流式编解码: 输入和编码数据都按随机长度分段送入
+template<typename _EL>
+static void TestStream(const char * pType)
+{
+	const int lens[] = {0, 1, 3000, 70000};
+
+	for(size_t l=0; l<sizeof(lens)/sizeof(lens[0]); l++)
+	{
+		for(int esc=0; esc<=1; esc++)
+		{
+			string what = string(pType) + " stream len " + to_string(lens[l]) + (esc ? " escape" : "");
+			vector<_EL> vecText = MakeData<_EL>(DATA_SKEWED, lens[l], 1000 + l);
+			CTestRand rnd(l + 1);
+
+			CHuffmanCodec<_EL, long long> enc;
+			enc.SetBlockSize(4096);
+			enc.SetStreams(esc ? 1 : 4);
+			enc.SetEscape(esc ? 4 : 0);
+
+			vector<char> vecData;
+			bool bok = enc.EncodeBegin([&](const char * pData, size_t iLen){
+				vecData.insert(vecData.end(), pData, pData + iLen);
+				return true;
+			});
+			for(size_t pos=0; pos<vecText.size() && bok; )
+			{
+				size_t len = min((size_t)rnd.Below(5000) + 1, vecText.size() - pos);
+				bok = enc.EncodeFeed(&vecText[pos], len);
+				pos += len;
+				if(rnd.Below(8) == 0)
+				{
+					bok = bok && enc.EncodeFlush();
+				}
+			}
+			bok = bok && enc.EncodeFinish();
+			HFMT_CHECK(bok && enc.GetStreamIn() == vecText.size() && enc.GetStreamOut() == vecData.size(), what + " encode");
+
+			CHuffmanCodec<_EL, long long> dec;
+			vector<_EL> vecDe;
+			bok = dec.DecodeBegin([&](const _EL * pElems, size_t iLen){
+				vecDe.insert(vecDe.end(), pElems, pElems + iLen);
+				return true;
+			});
+			for(size_t pos=0; pos<vecData.size() && bok; )
+			{
+				size_t len = min((size_t)rnd.Below(700) + 1, vecData.size() - pos);
+				bok = dec.DecodeFeed(&vecData[pos], len);
+				pos += len;
+			}
+			HFMT_CHECK(bok && dec.DecodeFinish() && vecDe == vecText, what + " decode");
+		}
+	}
+}
+
+// 码书: 训练、序列化、载入后编解码, 码书外的元素经转义
+template<typename _EL>
+static void TestCodebook(const char * pType)
+{
+	string what = string(pType) + " codebook";
+	vector<_EL> vecTrain = MakeData<_EL>(DATA_SKEWED, 20000, 7);
+
+	CHuffmanCodebook<_EL> book;
+	book.Train(&vecTrain[0], (long long)vecTrain.size());
+	HFMT_CHECK(book.Build(12), what + " build");
+
+	char * pBook = nullptr;
+	int iBookLen = 0;
+	HFMT_CHECK(book.Serialize(&pBook, &iBookLen) > 0, what + " serialize");
+
+	CHuffmanCodebook<_EL> loaded;
+	HFMT_CHECK(loaded.Load(pBook, iBookLen) && loaded.GetElemNum() == book.GetElemNum(), what + " load");
+	HFMT_CHECK(!loaded.Load(pBook, iBookLen - 1) || iBookLen == 1, what + " truncated load");
+	HFMT_CHECK(loaded.Load(pBook, iBookLen), what + " reload");
+	delete[] pBook;
+
+	// 测试数据含训练集之外的元素
+	const int lens[] = {0, 1, 3000};
+	for(size_t l=0; l<sizeof(lens)/sizeof(lens[0]); l++)
+	{
+		vector<_EL> vecText = MakeData<_EL>((l == 1) ? DATA_SINGLE : DATA_WIDE, lens[l], 8 + l);
+		CTestCfg cfg = {HFM_FMT_FRAME, 0, 0, 1, 0, HFM_LIMIT_PACKAGE_MERGE, 0, "codebook"};
+
+		CHuffmanCodec<_EL, long long> enc;
+		CHuffmanCodec<_EL, long long> dec;
+		Apply(enc, cfg);
+		Apply(dec, cfg);
+		enc.SetCodebook(&book);
+		dec.SetCodebook(&loaded);
+
+		for(int blocks=0; blocks<=1; blocks++)
+		{
+			enc.SetBlockSize(blocks ? 1000 : 0);
+			string name = what + (blocks ? " blocks" : "") + " len " + to_string(lens[l]);
+			int iTextLen = (int)vecText.size();
+			_EL * pText = iTextLen > 0 ? &vecText[0] : nullptr;
+
+			char * pOut = nullptr;
+			int iOutLen = 0;
+			int ret = enc.Encode(pText, iTextLen, &pOut, &iOutLen);
+			HFMT_CHECK(ret >= 0 && iOutLen <= enc.GetEncodeBound(iTextLen), name + " encode");
+			if(ret < 0)
+			{
+				continue;
+			}
+
+			_EL * pDe = nullptr;
+			int iDeLen = 0;
+			ret = dec.DecodeElems(pOut, iOutLen, &pDe, &iDeLen);
+			HFMT_CHECK(ret == iTextLen && (iTextLen == 0 || memcmp(pDe, pText, iTextLen * sizeof(_EL)) == 0), name + " decode");
+			delete[] pDe;
+			delete[] pOut;
+		}
+	}
+}
+
+// 码表缓存: 同一分布第二次编码命中, 结果与不用缓存时相同
+template<typename _EL>
+static void TestCache(const char * pType)
+{
+	string what = string(pType) + " cache";
+	vector<_EL> vecText = MakeData<_EL>(DATA_SKEWED, 5000, 11);
+	int iTextLen = (int)vecText.size();
+
+	// 转义、多路子流、分块时命中缓存的输出与不用缓存时相同
+	const int escs[] = {0, 4, 0, 0};
+	const int streams[] = {1, 1, 4, 1};
+	const int blocks[] = {0, 0, 0, 1500};
+
+	CHfmCodeCache<_EL> cache(64);
+	for(int fmt=HFM_FMT_PACKED; fmt<=HFM_FMT_FRAME; fmt++)
+	{
+		for(int c=0; c<4; c++)
+		{
+			if(fmt == HFM_FMT_PACKED && (streams[c] > 1 || blocks[c] > 0))
+			{
+				continue;
+			}
+			string cwhat = what + " fmt " + to_string(fmt) + " cfg " + to_string(c);
+
+			CHuffmanCodec<_EL, long long> plain;
+			CHuffmanCodec<_EL, long long> cached;
+			CHuffmanCodec<_EL, long long> reader;
+			CHuffmanCodec<_EL, long long> * codecs[3] = {&plain, &cached, &reader};
+			for(int k=0; k<3; k++)
+			{
+				codecs[k]->SetFormat(fmt);
+				codecs[k]->SetEscape(escs[c]);
+				codecs[k]->SetStreams(streams[c]);
+				codecs[k]->SetBlockSize(blocks[c]);
+			}
+			cached.SetCodeCache(&cache);
+			reader.SetCodeCache(&cache);
+
+			char * pRef = nullptr;
+			int iRefLen = 0;
+			plain.Encode(&vecText[0], iTextLen, &pRef, &iRefLen);
+
+			for(int k=0; k<2; k++)
+			{
+				char * pOut = nullptr;
+				int iOutLen = 0;
+				int ret = cached.Encode(&vecText[0], iTextLen, &pOut, &iOutLen);
+				HFMT_CHECK(ret == iRefLen && memcmp(pOut, pRef, iRefLen) == 0, cwhat + " same output");
+
+				_EL * pDe = nullptr;
+				int iDeLen = 0;
+				ret = cached.DecodeElems(pOut, iOutLen, &pDe, &iDeLen);
+				HFMT_CHECK(ret == iTextLen && memcmp(pDe, &vecText[0], iTextLen * sizeof(_EL)) == 0, cwhat + " decode");
+				delete[] pDe;
+
+				// 另一个解码器只凭帧头命中编码时加入的码表
+				if(fmt == HFM_FMT_FRAME)
+				{
+					long long llHits = cache.GetHits();
+					pDe = nullptr;
+					ret = reader.DecodeElems(pOut, iOutLen, &pDe, &iDeLen);
+					HFMT_CHECK(ret == iTextLen && memcmp(pDe, &vecText[0], iTextLen * sizeof(_EL)) == 0, cwhat + " reader decode");
+					HFMT_CHECK(cache.GetHits() > llHits, cwhat + " reader hits");
+					delete[] pDe;
+				}
+				delete[] pOut;
+			}
+			delete[] pRef;
+		}
+	}
+	HFMT_CHECK(cache.GetHits() >= 2 && cache.GetMisses() >= 1, what + " hits");
+
+	// 解码端未见过的码表: 首次建表加入, 再次命中
+	CHuffmanCodec<_EL, long long> writer;
+	writer.SetFormat(HFM_FMT_FRAME);
+	vector<_EL> vecOther = MakeData<_EL>(DATA_TWO, 3000, 12);
+	char * pOut = nullptr;
+	int iOutLen = 0;
+	writer.Encode(&vecOther[0], (int)vecOther.size(), &pOut, &iOutLen);
+
+	CHfmCodeCache<_EL> fresh(16);
+	CHuffmanCodec<_EL, long long> reader;
+	reader.SetFormat(HFM_FMT_FRAME);
+	reader.SetCodeCache(&fresh);
+	for(int k=0; k<2; k++)
+	{
+		_EL * pDe = nullptr;
+		int iDeLen = 0;
+		int ret = reader.DecodeElems(pOut, iOutLen, &pDe, &iDeLen);
+		HFMT_CHECK(ret == (int)vecOther.size() && memcmp(pDe, &vecOther[0], vecOther.size() * sizeof(_EL)) == 0, what + " fresh decode");
+		delete[] pDe;
+	}
+	HFMT_CHECK(fresh.GetHits() == 1 && fresh.GetMisses() == 1, what + " fresh hits");
+	delete[] pOut;
+}
+
+// 自适应编码器的流式接口, 输入输出均分段
+template<typename _EL>
+static void TestAdaptive(const char * pType)
+{
+	string what = string(pType) + " adaptive stream";
+	vector<_EL> vecText = MakeData<_EL>(DATA_WIDE, 20000, 5);
+	CTestRand rnd(3);
+
+	CHuffmanAdaptive<_EL> enc;
+	vector<char> vecData;
+	bool bok = enc.EncodeBegin([&](const char * pData, size_t iLen){
+		vecData.insert(vecData.end(), pData, pData + iLen);
+		return true;
+	});
+	for(size_t pos=0; pos<vecText.size() && bok; )
+	{
+		size_t len = min((size_t)rnd.Below(300) + 1, vecText.size() - pos);
+		bok = enc.EncodeFeed(&vecText[pos], len);
+		pos += len;
+	}
+	bok = bok && enc.EncodeFinish();
+	HFMT_CHECK(bok, what + " encode");
+
+	CHuffmanAdaptive<_EL> dec;
+	vector<_EL> vecDe;
+	bok = dec.DecodeBegin([&](const _EL * pElems, size_t iLen){
+		vecDe.insert(vecDe.end(), pElems, pElems + iLen);
+		return true;
+	});
+	for(size_t pos=0; pos<vecData.size() && bok; )
+	{
+		size_t len = min((size_t)rnd.Below(50) + 1, vecData.size() - pos);
+		bok = dec.DecodeFeed(&vecData[pos], len);
+		pos += len;
+	}
+	HFMT_CHECK(bok && dec.DecodeFinish() && vecDe == vecText, what + " decode");
+}
+
+// 自适应编码n个各不相同的元素的耗时(毫秒), 取3次中最短的
+static double AdaptiveDistinctMs(int n)
+{
+	vector<unsigned int> vecText(n);
+	for(int i=0; i<n; i++)
+	{
+		vecText[i] = (unsigned int)i * 2654435761u;
+	}
+
+	double best = 1e30;
+	for(int r=0; r<3; r++)
+	{
+		CHuffmanAdaptive<unsigned int> enc;
+		size_t iLen = 0;
+		auto t0 = chrono::steady_clock::now();
+		enc.EncodeBegin([&](const char *, size_t iDataLen){
+			iLen += iDataLen;
+			return true;
+		});
+		enc.EncodeFeed(&vecText[0], vecText.size());
+		enc.EncodeFinish();
+		best = min(best, chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count());
+	}
+
+	return best;
+}
+
+// 大字母表下自适应编码的耗时与元素个数近似成正比: 8倍元素平方级为64倍, 这里要求不超过32倍
+static void TestAdaptiveScaling()
+{
+	double t1 = AdaptiveDistinctMs(20000);
+	double t8 = AdaptiveDistinctMs(160000);
+	HFMT_CHECK(t8 < 32 * max(t1, 0.5), "adaptive wide alphabet scaling " + to_string(t1) + " ms -> " + to_string(t8) + " ms");
+}
+
+// 编译期码表
+struct CTestFreq { static constexpr unsigned int freq[] = {900, 50, 30, 20, 0, 1, 1, 7}; };
+constexpr unsigned int CTestFreq::freq[];
+
+static void TestStatic()
+{
+	typedef CHuffmanStatic<CTestFreq> _Codec;
+	vector<unsigned char> vecText = MakeData<unsigned char>(DATA_SKEWED, 3000, 21);
+	for(size_t i=0; i<vecText.size(); i++)
+	{
+		vecText[i] &= 7;
+	}
+
+	vector<char> vecOut((size_t)_Codec::GetEncodeBound((int)vecText.size()));
+	int iOutLen = _Codec::Encode(&vecText[0], (int)vecText.size(), &vecOut[0], (int)vecOut.size());
+	HFMT_CHECK(iOutLen > 0, "static encode");
+
+	vector<unsigned char> vecDe(vecText.size());
+	HFMT_CHECK(_Codec::Decode(&vecOut[0], iOutLen, &vecDe[0], (int)vecDe.size()) && vecDe == vecText, "static decode");
+
+	unsigned char bad = 8;
+	HFMT_CHECK(_Codec::Encode(&bad, 1, &vecOut[0], (int)vecOut.size()) < 0, "static out of range");
+}
+
+// 统计: 同一对象依次统计多条长短不一的消息, 结果与map计数相同, 不残留上一条的计数
+template<typename _EL>
+static void TestStat(const char * pType)
+{
+	const int lens[] = {300000, 5, 0, 200, 70000, 1, 3000};
+	CElemStat<_EL> stat;
+
+	for(size_t l=0; l<sizeof(lens)/sizeof(lens[0]); l++)
+	{
+		string what = string(pType) + " stat len " + to_string(lens[l]);
+		vector<_EL> vecText = MakeData<_EL>((l & 1) ? DATA_WIDE : DATA_SKEWED, lens[l], 40 + l);
+		int iHalf = lens[l] / 3;
+
+		// 分两次累加, 大段走交错计数, 小段直接计数
+		stat.Stat(vecText.empty() ? nullptr : &vecText[0], iHalf);
+		stat.Add(vecText.empty() ? nullptr : &vecText[iHalf], lens[l] - iHalf);
+
+		map<_EL, long long> ref;
+		for(size_t i=0; i<vecText.size(); i++)
+		{
+			ref[vecText[i]]++;
+		}
+
+		int n = stat.GetElemNum();
+		vector<_EL> vecElems(n + 1);
+		vector<long long> vecCnts(n + 1);
+		HFMT_CHECK(n == (int)ref.size() && stat.GetStat(&vecElems[0], &vecCnts[0], n) == n, what + " count");
+
+		bool bok = (n == (int)ref.size());
+		int k = 0;
+		for(typename map<_EL, long long>::iterator iter=ref.begin(); bok && iter!=ref.end(); iter++, k++)
+		{
+			bok = (vecElems[k] == iter->first && vecCnts[k] == iter->second);
+		}
+		HFMT_CHECK(bok, what + " order and counts");
+	}
+}
+
+// 限长: 斐波那契权值使不限长码长超过40位, 31位及以上的限长同样可行
+static void TestLimit()
+{
+	const int n = 45;
+	vector<long long> vecWeights(n);
+	vecWeights[0] = 1;
+	vecWeights[1] = 1;
+	for(int i=2; i<n; i++)
+	{
+		vecWeights[i] = vecWeights[i-1] + vecWeights[i-2];
+	}
+
+	CHuffman<long long> huff;
+	huff.CreatCodeLens(&vecWeights[0], n);
+	HFMT_CHECK(*max_element(huff.GetCodeLens().begin(), huff.GetCodeLens().end()) > 40, "fibonacci code length");
+
+	const int limits[] = {6, 20, 31, 32, 40};
+	for(size_t l=0; l<sizeof(limits)/sizeof(limits[0]); l++)
+	{
+		for(int mode=HFM_LIMIT_PACKAGE_MERGE; mode<=HFM_LIMIT_KRAFT; mode++)
+		{
+			string what = "limit " + to_string(limits[l]) + " mode " + to_string(mode);
+			vector<int> vecLens = huff.GetCodeLens();
+			bool bok = HfmLimitCodeLens(&vecWeights[0], n, limits[l], mode, &vecLens[0]);
+			HFMT_CHECK(bok, what);
+
+			// 码长不超过限长且满足Kraft不等式
+			long long kraft = 0;
+			int maxlen = 0;
+			for(int i=0; i<n && bok; i++)
+			{
+				maxlen = max(maxlen, vecLens[i]);
+				kraft += 1LL << (HFM_MAX_CODE_LEN - vecLens[i]);
+			}
+			HFMT_CHECK(maxlen <= limits[l] && kraft <= (1LL << HFM_MAX_CODE_LEN), what + " lengths");
+		}
+	}
+
+	// 只算整数码字时, getCode()按需生成的字符码字与整数码字一致
+	CHuffman<long long> canon;
+	bool bCanon = canon.CanonicCodes(&vecWeights[0], n, 20);
+	const vector<unsigned long long> & vecCodes = canon.GetIntCodes();
+	for(int i=0; i<n && bCanon; i++)
+	{
+		char * pCode = nullptr;
+		int iLen = 0;
+		bCanon = canon.getCode(i, &pCode, &iLen) && iLen == canon.GetCodeLens()[i];
+		for(int b=0; b<iLen && bCanon; b++)
+		{
+			bCanon = pCode[b] == (char)((vecCodes[i] >> (iLen - 1 - b)) & 1);
+		}
+	}
+	HFMT_CHECK(bCanon, "lazy char codes");
+
+	HFMT_CHECK(!HfmLimitFeasible(65, 6) && HfmLimitFeasible(64, 6) && HfmLimitFeasible(0x7FFFFFFF, 31), "limit feasible");
+}
+
+// 损坏的帧不应解码成功或越界
+static void TestCorrupt()
+{
+	vector<unsigned char> vecText = MakeData<unsigned char>(DATA_SKEWED, 5000, 31);
+	CHuffmanCodec<unsigned char, long long> codec;
+	codec.SetFormat(HFM_FMT_FRAME);
+	codec.SetStreams(4);
+
+	char * pOut = nullptr;
+	int iOutLen = 0;
+	codec.Encode(&vecText[0], (int)vecText.size(), &pOut, &iOutLen);
+
+	for(int cut=0; cut<12; cut++)
+	{
+		unsigned char * pDe = nullptr;
+		int iDeLen = 0;
+		int ret = codec.DecodeElems(pOut, cut, &pDe, &iDeLen);
+		HFMT_CHECK(ret < 0, "truncated frame " + to_string(cut));
+		if(ret >= 0)
+		{
+			delete[] pDe;
+		}
+	}
+	delete[] pOut;
+}
+
+int main()
+{
+	TestFormats<char>("char");
+	TestFormats<unsigned char>("uchar");
+	TestFormats<short>("short");
+	TestFormats<unsigned short>("ushort");
+	TestFormats<int>("int");
+	TestFormats<unsigned int>("uint");
+	TestFormats<long long>("int64");
+	TestSimdLevels();
+
+	TestStream<unsigned char>("uchar");
+	TestStream<unsigned short>("ushort");
+	TestStream<int>("int");
+
+	TestCodebook<unsigned char>("uchar");
+	TestCodebook<short>("short");
+	TestCodebook<unsigned int>("uint");
+
+	TestCache<unsigned char>("uchar");
+	TestCache<short>("short");
+	TestCache<int>("int");
+
+	TestAdaptive<unsigned char>("uchar");
+	TestAdaptive<unsigned int>("uint");
+	TestAdaptiveScaling();
+
+	TestStat<char>("char");
+	TestStat<unsigned char>("uchar");
+	TestStat<short>("short");
+	TestStat<unsigned short>("ushort");
+	TestStatic();
+	TestLimit();
+	TestCorrupt();
+
+	printf("%d checks, %d failed\n", g_iChecks, g_iFails);
+	return g_iFails == 0 ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+
+// HuffmanThreadPool.h : 并行统计/分块编解码用的线程池
+//
+
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+
+/*固定线程数的线程池, 只提供ParallelFor
+  调用线程也参与执行, 只等待任务项完成而不等待排队中的辅助任务, 可在工作线程中嵌套调用*/
+class CHfmThreadPool
+{
+public:
+	// iThreads: 0 - 硬件线程数
+	CHfmThreadPool(int iThreads = 0)
+		:m_bStop(false)
+	{
+		if(iThreads <= 0)
+		{
+			iThreads = max(1, (int)thread::hardware_concurrency());
+		}
+
+		// 调用线程参与执行, 只需另起iThreads-1个线程
+		for(int i=1; i<iThreads; i++)
+		{
+			m_vecThreads.push_back(thread([this]{ WorkerProc(); }));
+		}
+	}
+
+	~CHfmThreadPool()
+	{
+		{
+			lock_guard<mutex> lock(m_mtx);
+			m_bStop = true;
+		}
+		m_cv.notify_all();
+
+		for(size_t i=0; i<m_vecThreads.size(); i++)
+		{
+			m_vecThreads[i].join();
+		}
+	}
+
+	int GetThreadNum(){ return (int)m_vecThreads.size() + 1; }
+
+	// 并行执行fn(0) .. fn(n-1), 返回时全部完成
+	void ParallelFor(int n, const function<void(int)> & fn)
+	{
+		if(n <= 0)
+		{
+			return;
+		}
+		if(n == 1 || m_vecThreads.empty())
+		{
+			for(int i=0; i<n; i++)
+			{
+				fn(i);
+			}
+			return;
+		}
+
+		shared_ptr<_ForState> state = make_shared<_ForState>(n, fn);
+
+		int helpers = min(n - 1, (int)m_vecThreads.size());
+		{
+			lock_guard<mutex> lock(m_mtx);
+			for(int i=0; i<helpers; i++)
+			{
+				m_deqTasks.push_back([state]{ state->Run(); });
+			}
+		}
+		m_cv.notify_all();
+
+		state->Run();
+
+		unique_lock<mutex> lock(state->mtx);
+		state->cv.wait(lock, [&state]{ return state->done == state->n; });
+	}
+
+	// 进程内共用的线程池
+	static CHfmThreadPool & Default()
+	{
+		static CHfmThreadPool pool;
+		return pool;
+	}
+
+private:
+	struct _ForState
+	{
+		_ForState(int cnt, const function<void(int)> & f)
+			:n(cnt), next(0), done(0), fn(f)
+		{
+		}
+
+		void Run()
+		{
+			int finished = 0;
+			for(int i=next++; i<n; i=next++)
+			{
+				fn(i);
+				finished++;
+			}
+
+			if(finished > 0)
+			{
+				lock_guard<mutex> lock(mtx);
+				done += finished;
+				if(done == n)
+				{
+					cv.notify_all();
+				}
+			}
+		}
+
+		int n;
+		atomic<int> next;
+		int done;
+		function<void(int)> fn;
+		mutex mtx;
+		condition_variable cv;
+	};
+
+	void WorkerProc()
+	{
+		for(;;)
+		{
+			function<void()> task;
+			{
+				unique_lock<mutex> lock(m_mtx);
+				m_cv.wait(lock, [this]{ return m_bStop || !m_deqTasks.empty(); });
+				if(m_bStop && m_deqTasks.empty())
+				{
+					return;
+				}
+				task = move(m_deqTasks.front());
+				m_deqTasks.pop_front();
+			}
+			task();
+		}
+	}
+
+private:
+	vector<thread>				m_vecThreads;
+	deque<function<void()>>		m_deqTasks;
+	mutex						m_mtx;
+	condition_variable			m_cv;
+	bool						m_bStop;
+};
@@ -0,0 +1,487 @@
+
+// HuffmanZip.cpp : 文件压缩/解压命令行工具, 输入输出文件均经内存映射访问
+//
+// 用法: HuffmanZip c|d [-b 块大小] [-t 线程数] [-l 最长码长] [-s 子流路数] 输入文件 输出文件
+//
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <memory>
+#include "Huffman.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+/*文件格式:
+  [HFMZ 4字节]{[帧长度 varint][帧]}...[0]
+  每段最多HFMZ_SEGMENT字节, 编码为一个自描述帧(分块编码时为分块帧), 以长度0结束
+  帧直接编码到输出文件中, 帧长度事先未知, 固定用HFMZ_LEN_BYTES字节的varint(高位补0x80)*/
+#define HFMZ_MAGIC			"HFMZ"
+#define HFMZ_SEGMENT		(256*1024*1024)		// 每段字节数, 不超过int
+#define HFMZ_BLOCK			(1024*1024)			// 默认块大小
+#define HFMZ_LEN_BYTES		5					// 帧长度字段的字节数
+
+
+/*内存映射文件*/
+class CMappedFile
+{
+public:
+	CMappedFile()
+		:m_pData(nullptr), m_llSize(0), m_bWrite(false)
+	{
+#ifdef _WIN32
+		m_hFile = INVALID_HANDLE_VALUE;
+		m_hMap = NULL;
+#else
+		m_fd = -1;
+#endif
+	}
+	~CMappedFile(){ Close(); }
+
+	// 只读打开
+	bool Open(const char * pPath);
+	// 新建可写文件, 大小为llSize
+	bool Create(const char * pPath, long long llSize);
+	// 解除映射, 可写文件截断到llSize(小于0不截断)
+	bool Close(long long llSize = -1);
+
+	unsigned char * GetData(){ return m_pData; }
+	long long GetSize(){ return m_llSize; }
+
+private:
+	bool Map();
+
+private:
+	unsigned char *	m_pData;
+	long long		m_llSize;
+	bool			m_bWrite;
+#ifdef _WIN32
+	HANDLE			m_hFile;
+	HANDLE			m_hMap;
+#else
+	int				m_fd;
+#endif
+};
+
+#ifdef _WIN32
+
+bool CMappedFile::Open(const char * pPath)
+{
+	m_hFile = CreateFileA(pPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(m_hFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(m_hFile, &size))
+	{
+		return false;
+	}
+
+	m_llSize = size.QuadPart;
+	m_bWrite = false;
+	return Map();
+}
+
+bool CMappedFile::Create(const char * pPath, long long llSize)
+{
+	m_hFile = CreateFileA(pPath, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(m_hFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	m_llSize = llSize;
+	m_bWrite = true;
+	return Map();
+}
+
+bool CMappedFile::Map()
+{
+	// 空文件不能映射
+	if(m_llSize == 0)
+	{
+		return true;
+	}
+
+	DWORD protect = m_bWrite ? PAGE_READWRITE : PAGE_READONLY;
+	m_hMap = CreateFileMappingA(m_hFile, NULL, protect, (DWORD)(m_llSize >> 32), (DWORD)m_llSize, NULL);
+	if(m_hMap == NULL)
+	{
+		return false;
+	}
+
+	m_pData = (unsigned char *)MapViewOfFile(m_hMap, m_bWrite ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+	return m_pData != nullptr;
+}
+
+bool CMappedFile::Close(long long llSize)
+{
+	bool bok = true;
+
+	if(m_pData != nullptr)
+	{
+		UnmapViewOfFile(m_pData);
+		m_pData = nullptr;
+	}
+	if(m_hMap != NULL)
+	{
+		CloseHandle(m_hMap);
+		m_hMap = NULL;
+	}
+	if(m_hFile != INVALID_HANDLE_VALUE)
+	{
+		if(m_bWrite && llSize >= 0)
+		{
+			LARGE_INTEGER pos;
+			pos.QuadPart = llSize;
+			bok = SetFilePointerEx(m_hFile, pos, NULL, FILE_BEGIN) && SetEndOfFile(m_hFile);
+		}
+		CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+
+	return bok;
+}
+
+#else
+
+bool CMappedFile::Open(const char * pPath)
+{
+	m_fd = open(pPath, O_RDONLY);
+	if(m_fd < 0)
+	{
+		return false;
+	}
+
+	struct stat st;
+	if(fstat(m_fd, &st) != 0)
+	{
+		return false;
+	}
+
+	m_llSize = st.st_size;
+	m_bWrite = false;
+	return Map();
+}
+
+bool CMappedFile::Create(const char * pPath, long long llSize)
+{
+	m_fd = open(pPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(m_fd < 0 || ftruncate(m_fd, (off_t)llSize) != 0)
+	{
+		return false;
+	}
+
+	m_llSize = llSize;
+	m_bWrite = true;
+	return Map();
+}
+
+bool CMappedFile::Map()
+{
+	// 空文件不能映射
+	if(m_llSize == 0)
+	{
+		return true;
+	}
+
+	int prot = m_bWrite ? (PROT_READ | PROT_WRITE) : PROT_READ;
+	void * p = mmap(nullptr, (size_t)m_llSize, prot, MAP_SHARED, m_fd, 0);
+	if(p == MAP_FAILED)
+	{
+		return false;
+	}
+
+	m_pData = (unsigned char *)p;
+
+	// 顺序访问, 提示内核预读
+	madvise(m_pData, (size_t)m_llSize, MADV_SEQUENTIAL);
+	return true;
+}
+
+bool CMappedFile::Close(long long llSize)
+{
+	bool bok = true;
+
+	if(m_pData != nullptr)
+	{
+		munmap(m_pData, (size_t)m_llSize);
+		m_pData = nullptr;
+	}
+	if(m_fd >= 0)
+	{
+		if(m_bWrite && llSize >= 0)
+		{
+			bok = (ftruncate(m_fd, (off_t)llSize) == 0);
+		}
+		close(m_fd);
+		m_fd = -1;
+	}
+
+	return bok;
+}
+
+#endif
+
+// 定长varint: 不足n字节时以0x80补齐, 仍可由HfmGetVarint读取
+static unsigned char * PutVarintFixed(unsigned char * p, unsigned long long v, int n)
+{
+	for(int i=0; i<n-1; i++)
+	{
+		*p++ = (unsigned char)((v & 0x7F) | 0x80);
+		v >>= 7;
+	}
+	*p++ = (unsigned char)v;
+	return p;
+}
+
+// 压缩: 每段直接在映射的输入页上统计、建表, 编码到映射的输出页上
+// pPool: 统计和分块编解码用的线程池, nullptr为默认线程池; iThreads为1时单线程
+static bool Compress(CMappedFile & in, const char * pOutPath, int iBlockSize, int iThreads, CHfmThreadPool * pPool, int iLimit, int iStreams, long long & llOutLen)
+{
+	long long llInLen = in.GetSize();
+
+	CHuffmanCodec<unsigned char, int> codec;
+	codec.SetFormat(HFM_FMT_FRAME);
+	codec.SetBlockSize(iBlockSize, iThreads);
+	codec.SetThreadPool(pPool);
+	// 分块时各块在线程池中单线程统计, 多线程统计只用于不超过一块的段
+	codec.SetStatThreads(iThreads);
+	codec.SetCodeLenLimit(iLimit);
+	codec.SetStreams(iStreams);
+
+	// 输出文件按各段帧长度上限建立, 结束时截断到实际长度
+	long long llBound = 4 + 1;
+	for(long long pos=0; pos<llInLen; pos+=HFMZ_SEGMENT)
+	{
+		llBound += HFMZ_LEN_BYTES + codec.GetEncodeBound((int)min((long long)HFMZ_SEGMENT, llInLen - pos));
+	}
+
+	CMappedFile out;
+	if(!out.Create(pOutPath, llBound))
+	{
+		return false;
+	}
+
+	unsigned char * p = out.GetData();
+	unsigned char * end = p + llBound;
+	memcpy(p, HFMZ_MAGIC, 4);
+	p += 4;
+
+	for(long long pos=0; pos<llInLen; pos+=HFMZ_SEGMENT)
+	{
+		int len = (int)min((long long)HFMZ_SEGMENT, llInLen - pos);
+		unsigned char * pFrame = p + HFMZ_LEN_BYTES;
+		int iCap = (int)min((long long)0x7FFFFFFF, (long long)(end - pFrame));
+
+		int iFrameLen = codec.EncodeTo(in.GetData() + pos, len, (char *)pFrame, iCap);
+		if(iFrameLen < 0)
+		{
+			out.Close(0);
+			return false;
+		}
+
+		PutVarintFixed(p, (unsigned long long)iFrameLen, HFMZ_LEN_BYTES);
+		p = pFrame + iFrameLen;
+	}
+
+	*p++ = 0;
+
+	llOutLen = p - out.GetData();
+	return out.Close(llOutLen);
+}
+
+// 解压: 先扫描各段帧头求出原文长度, 建好输出文件后逐段解码到对应位置
+static bool Decompress(CMappedFile & in, const char * pOutPath, int iThreads, CHfmThreadPool * pPool, long long & llOutLen)
+{
+	const unsigned char * p = in.GetData();
+	const unsigned char * end = p + in.GetSize();
+
+	if(in.GetSize() < 5 || memcmp(p, HFMZ_MAGIC, 4) != 0)
+	{
+		return false;
+	}
+	p += 4;
+
+	CHuffmanCodec<unsigned char, int> codec;
+	codec.SetFormat(HFM_FMT_FRAME);
+	codec.SetBlockSize(0, iThreads);
+	codec.SetThreadPool(pPool);
+
+	vector<const unsigned char *> vecFrames;
+	vector<int> vecFrameLens;
+	vector<long long> vecOutPos(1, 0);
+
+	for(;;)
+	{
+		unsigned long long len = 0;
+		if(!HfmGetVarint(p, end, len) || len > (unsigned long long)(end - p) || len > 0x7FFFFFFF)
+		{
+			return false;
+		}
+		if(len == 0)
+		{
+			break;
+		}
+
+		// 由帧头取解码后的长度
+		int count = codec.GetDecodedSize((const char *)p, (int)len);
+		if(count < 0 || count > HFMZ_SEGMENT)
+		{
+			return false;
+		}
+
+		vecFrames.push_back(p);
+		vecFrameLens.push_back((int)len);
+		vecOutPos.push_back(vecOutPos.back() + (long long)count);
+		p += len;
+	}
+
+	if(p != end)
+	{
+		return false;
+	}
+
+	llOutLen = vecOutPos.back();
+
+	CMappedFile out;
+	if(!out.Create(pOutPath, llOutLen))
+	{
+		return false;
+	}
+
+	// 各段直接解码到映射的输出页上
+	for(size_t k=0; k<vecFrames.size(); k++)
+	{
+		int iTextLen = (int)(vecOutPos[k+1] - vecOutPos[k]);
+
+		if(codec.DecodeTo((unsigned char *)vecFrames[k], vecFrameLens[k], (char *)out.GetData() + vecOutPos[k], iTextLen) != iTextLen)
+		{
+			out.Close(0);
+			return false;
+		}
+	}
+
+	return out.Close();
+}
+
+static void Usage()
+{
+	printf("usage: HuffmanZip c|d [-b blocksize] [-t threads] [-l maxcodelen] [-s streams] input output\n");
+	printf("  c          compress\n");
+	printf("  d          decompress\n");
+	printf("  -b         block size in bytes, 0 - one block per segment (default %d)\n", HFMZ_BLOCK);
+	printf("  -t         threads, 0 - all cores, 1 - single thread (default 0)\n");
+	printf("  -l         max code length, 0 - unlimited (default 0)\n");
+	printf("  -s         interleaved streams per block, power of two 1..%d (default 1)\n", HFM_MAX_STREAMS);
+}
+
+int main(int argc, char * argv[])
+{
+	if(argc < 4 || (strcmp(argv[1], "c") != 0 && strcmp(argv[1], "d") != 0))
+	{
+		Usage();
+		return 1;
+	}
+
+	bool bCompress = (argv[1][0] == 'c');
+	int iBlockSize = HFMZ_BLOCK;
+	int iThreads = 0;
+	int iLimit = 0;
+	int iStreams = 1;
+	int i = 2;
+
+	for(; i+1<argc && argv[i][0] == '-'; i+=2)
+	{
+		int v = atoi(argv[i+1]);
+		if(strcmp(argv[i], "-b") == 0 && v >= 0)
+		{
+			iBlockSize = v;
+		}
+		else if(strcmp(argv[i], "-t") == 0 && v >= 0)
+		{
+			iThreads = v;
+		}
+		else if(strcmp(argv[i], "-l") == 0 && v >= 0 && v <= HFM_MAX_CODE_LEN)
+		{
+			iLimit = v;
+		}
+		else if(strcmp(argv[i], "-s") == 0 && v >= 1 && v <= HFM_MAX_STREAMS)
+		{
+			iStreams = v;
+		}
+		else
+		{
+			Usage();
+			return 1;
+		}
+	}
+
+	if(argc - i != 2)
+	{
+		Usage();
+		return 1;
+	}
+
+	const char * pInPath = argv[i];
+	const char * pOutPath = argv[i+1];
+
+	// 块大小为0时每段一块
+	if(iBlockSize == 0 || iBlockSize > HFMZ_SEGMENT)
+	{
+		iBlockSize = HFMZ_SEGMENT;
+	}
+
+	CMappedFile in;
+	if(!in.Open(pInPath))
+	{
+		fprintf(stderr, "cannot open %s\n", pInPath);
+		return 2;
+	}
+
+	// 指定线程数时建立对应大小的线程池, 0用默认线程池(全部核)
+	unique_ptr<CHfmThreadPool> pPool;
+	if(iThreads > 1)
+	{
+		pPool.reset(new CHfmThreadPool(iThreads));
+	}
+
+	auto t0 = chrono::steady_clock::now();
+
+	long long llOutLen = 0;
+	bool bok = bCompress ? Compress(in, pOutPath, iBlockSize, iThreads, pPool.get(), iLimit, iStreams, llOutLen)
+						 : Decompress(in, pOutPath, iThreads, pPool.get(), llOutLen);
+
+	auto t1 = chrono::steady_clock::now();
+
+	if(!bok)
+	{
+		fprintf(stderr, "%s failed: %s -> %s\n", bCompress ? "compress" : "decompress", pInPath, pOutPath);
+		return 3;
+	}
+
+	long long llInLen = in.GetSize();
+	long long llRawLen = bCompress ? llInLen : llOutLen;
+	long long llPackLen = bCompress ? llOutLen : llInLen;
+	double sec = chrono::duration<double>(t1 - t0).count();
+
+	printf("%s: %lld -> %lld bytes, ratio %.2f%%, %.3f s, %.1f MB/s\n",
+		bCompress ? "compress" : "decompress", llInLen, llOutLen,
+		llRawLen > 0 ? 100.0 * llPackLen / llRawLen : 0.0,
+		sec, sec > 0 ? llRawLen / sec / (1024 * 1024) : 0.0);
+
+	return 0;
+}